@@ -1,46 +1,12 @@
 #-------------------------------------------------
 #
-# Project created by QtCreator 2013-02-16T14:16:45
+# LemonCaml (app.pro) and its tests (tests/)
 #
 #-------------------------------------------------
 
-QT       += core \
-    widgets \
-    printsupport
+TEMPLATE = subdirs
 
-TARGET = lemoncaml
+SUBDIRS = app \
+    tests
 
-TEMPLATE = app
-
-
-SOURCES += main.cpp \
-    camldevwindow.cpp \
-    camldevsettings.cpp \
-    inputzone.cpp \
-    highlighter.cpp \
-    treeparser.cpp \
-    common.cpp \
-    findreplace.cpp
-
-HEADERS += \
-    camldevwindow.h \
-    camldevsettings.h \
-    inputzone.h \
-    highlighter.h \
-    treeparser.h \
-    common.h \
-    colorButton.h \
-    findreplace.h
-
-RESOURCES += \
-    icons.qrc
-
-lemoncaml.files += lemoncaml
-lemoncaml.path = /usr/bin/
-
-INSTALLS += lemoncaml
-
-TRANSLATIONS += lemoncaml_fr.ts \
-   lemoncaml_es.ts
-
-RC_FILE = progicon.rc
+app.file = app.pro
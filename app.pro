@@ -0,0 +1,55 @@
+#-------------------------------------------------
+#
+# Project created by QtCreator 2013-02-16T14:16:45
+#
+#-------------------------------------------------
+
+QT       += core \
+    widgets \
+    printsupport \
+    concurrent
+
+TARGET = lemoncaml
+
+TEMPLATE = app
+
+CONFIG += c++11
+
+SOURCES += main.cpp \
+    camldevwindow.cpp \
+    camldevsettings.cpp \
+    inputzone.cpp \
+    highlighter.cpp \
+    treeparser.cpp \
+    common.cpp \
+    findreplace.cpp \
+    camllexer.cpp \
+    searchindex.cpp \
+    phraseindex.cpp
+
+HEADERS += \
+    camldevwindow.h \
+    camldevsettings.h \
+    inputzone.h \
+    highlighter.h \
+    treeparser.h \
+    common.h \
+    colorButton.h \
+    findreplace.h \
+    camllexer.h \
+    searchindex.h \
+    phraseindex.h \
+    keywords_table.h
+
+RESOURCES += \
+    icons.qrc
+
+lemoncaml.files += lemoncaml
+lemoncaml.path = /usr/bin/
+
+INSTALLS += lemoncaml
+
+TRANSLATIONS += lemoncaml_fr.ts \
+   lemoncaml_es.ts
+
+RC_FILE = progicon.rc
@@ -27,7 +27,7 @@ CamlDevSettings::CamlDevSettings(QWidget *parent, QSettings *set, QSettings *glo
   QString camlPath = settings->value("General/camlPath",(globalset->value("General/camlPath", "./caml/CamlLightToplevel").toString())).toString();
 #endif
   QString camlArgs = settings->value("General/camlArgs", (globalset->value("General/camlArgs", "-stdlib ./caml/lib").toString())).toString();
-  QString kwfilePath = settings->value("General/keywordspath", (globalset->value("General/keywordspath", "./keywords").toString())).toString();
+  QString kwfilePath = settings->value("General/keywordspath", (globalset->value("General/keywordspath", "").toString())).toString();
   QString treeModelsPath = settings->value("General/treeModelsPath",(globalset->value("General/treeModelsPath", "./gentree/").toString())).toString();
   bool drawTrees = (settings->value("General/drawTrees",0).toInt() == 1)?true:false;
   
@@ -48,8 +48,8 @@ CamlDevSettings::CamlDevSettings(QWidget *parent, QSettings *set, QSettings *glo
   It should be an absolute path if LemonCaml gets opened from another directory than \
   the place it got compiled in..."));
   this->keywordsPathField = new QLineEdit(kwfilePath, this);
-  this->keywordsPathField->setWhatsThis(tr("This is the path to the \"keywords\" file, which is typically located in the same directory as LemonCaml.<br /> \
-  It should be an absolute path if LemonCaml gets opened from another directory than \
+  this->keywordsPathField->setWhatsThis(tr("This is the path to an optional \"keywords\" file. Its entries override or extend the built-in keywords, \
+  which stay highlighted.<br /> Leave it empty to use the built-in keywords only. It should be an absolute path if LemonCaml gets opened from another directory than \
   the place it got compiled in..."));
   this->numberField = new QSpinBox(this);
   this->numberField->setWhatsThis(tr("This counts how many recent files are to be kept in memory in the \"File->Recent files\" menu."));
@@ -94,11 +94,11 @@ CamlDevSettings::CamlDevSettings(QWidget *parent, QSettings *set, QSettings *glo
   this->colorsTab = new QWidget;
   QVBoxLayout *colorsTabLayout = new QVBoxLayout();
   QStringList colorsToSet;
-  colorsToSet << "variableDec" << "loop" << "comment" << "preproc" << "boolean" << "string" << "char" << "builtInType" << "builtInFunction" << "searchResult";
+  colorsToSet << "variableDec" << "loop" << "comment" << "preproc" << "boolean" << "string" << "char" << "builtInType" << "builtInFunction" << "searchResult" << "userFunction" << "userType" << "userConstructor";
   QStringList defaultColors;
-  defaultColors << "186,19,155" << "0,163,49" << "181,181,181" << "0,224,49" << "0,75,255" << "255,0,0" << "255,0,0" << "0,21,156" << "0,21,156" << "255,255,0";
+  defaultColors << "186,19,155" << "0,163,49" << "181,181,181" << "0,224,49" << "0,75,255" << "255,0,0" << "255,0,0" << "0,21,156" << "0,21,156" << "255,255,0" << "128,64,0" << "0,128,128" << "128,0,128";
   QStringList helpers;
-  helpers << tr("Variable declarations") << tr("Loops") << tr("Comments") << tr("Preprocessor commands") << tr("Booleans") << tr("Strings") << tr("Characters") << tr("Built in types") << tr("Built in functions") << tr("Search results");
+  helpers << tr("Variable declarations") << tr("Loops") << tr("Comments") << tr("Preprocessor commands") << tr("Booleans") << tr("Strings") << tr("Characters") << tr("Built in types") << tr("Built in functions") << tr("Search results") << tr("User-defined functions") << tr("User-defined types") << tr("User-defined constructors");
   
   for(int i = 0; i < colorsToSet.count(); i++)
   {
@@ -142,7 +142,10 @@ void CamlDevSettings::saveSettings()
   settings->setValue("General/camlPath", camlPathField->text());
   settings->setValue("General/camlArgs", camlArgsField->text());
   settings->setValue("Recent/number", numberField->value());
-  settings->setValue("General/keywordspath", keywordsPathField->text());
+  if(keywordsPathField->text() != "")
+    settings->setValue("General/keywordspath", keywordsPathField->text());
+  else
+    settings->remove("General/keywordspath");
   settings->setValue("General/drawTrees", (acceptTrees->checkState() == Qt::Checked)?1:0);
   settings->setValue("General/treeModelsPath", treeModelsPathField->text());
   this->close();
@@ -163,7 +166,6 @@ void CamlDevSettings::autoConfDirs()
    }
    this->camlPathField->setText(camlPath);
    this->camlArgsField->setText("-stdlib \"" + curPath + "caml" + QDir::separator() + "lib\"");
-   this->keywordsPathField->setText(curPath + "keywords");
    this->treeModelsPathField->setText(curPath + "gentree" + QDir::separator());
    
 }
@@ -60,27 +60,33 @@ QMainWindow(parent)
    this->outputZone->setReadOnly(true);
    this->outputZone->setTabStopWidth(20);
    
-   QString kwfileloc = settings->value("General/keywordspath", (globalSettings->value("General/keywordspath", "./keywords").toString())).toString();
-   
-   QFile kwfile(kwfileloc);
+   /* The keywords are built in; a keywords file, when configured, only overrides them */
    QStringList kwds;
    
-   if(kwfile.open(QIODevice::ReadOnly | QIODevice::Text))
+   QString kwfileloc = settings->value("General/keywordspath", (globalSettings->value("General/keywordspath", "").toString())).toString();
+   if(kwfileloc != "")
    {
-      QTextStream kstream(&kwfile);
-      QString st = kstream.readLine(256);
-      while(st != "")
+      QFile kwfile(kwfileloc);
+      
+      if(kwfile.open(QIODevice::ReadOnly | QIODevice::Text))
       {
-         kwds << st;
-         st = kstream.readLine(256);
+         QTextStream kstream(&kwfile);
+         QString st = kstream.readLine(256);
+         while(st != "")
+         {
+            kwds << st;
+            st = kstream.readLine(256);
+         }
+         kwfile.close();
+      }
+      else
+      {
+         QMessageBox::warning(this, tr("Warning"), tr("Unable to open the keywords file. Only the built-in keywords will be highlighted."));
       }
-      kwfile.close();
-   }
-   else
-   {
-      QMessageBox::warning(this, tr("Warning"), tr("Unable to open the keywords file. There will likely be no syntax highlighting."));
    }
    this->hilit = new highlighter(inputZone->document(), &kwds, this->settings);
+   this->hilit->setEditor(inputZone);
+   this->phrases = new phraseIndex(inputZone->document(), this);
    bool isHighlighting = (settings->value("Input/syntaxHighlight",1).toInt() == 1);
    
    if(!isHighlighting)
@@ -100,6 +106,7 @@ QMainWindow(parent)
    /* Find/Replace */
    
    this->find = new findReplace(inputZone, hilit);
+   this->find->setIndexed(settings->value("Input/searchIndex", 1).toInt() == 1);
    split->addWidget(this->inputZone);
    split->addWidget(this->outputZone);
    split->showMaximized();
@@ -142,6 +149,8 @@ QMainWindow(parent)
    this->actionSave->setShortcut(QKeySequence(QKeySequence::Save));
    this->actionAutoIndent = new QAction(tr("Indent code"),this);
    this->actionAutoIndent->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_W));
+   this->actionIndentPhrase = new QAction(tr("Indent current phrase"),this);
+   this->actionIndentPhrase->setShortcut(QKeySequence(Qt::CTRL + Qt::SHIFT + Qt::Key_W));
    this->actionFollowCursor = new QAction(tr("Indent code while typing"),this);
    this->actionFollowCursor->setCheckable(true);
    this->actionFollowCursor->setChecked(inputZone->getHandleEnter());
@@ -226,6 +235,7 @@ QMainWindow(parent)
    this->menuEdit->addAction(actionDelete);
    this->menuEdit->addSeparator();
    this->menuEdit->addAction(actionAutoIndent);
+   this->menuEdit->addAction(actionIndentPhrase);
    this->menuEdit->addAction(actionFollowCursor);
    this->menuEdit->addSeparator();
    this->menuEdit->addAction(actionFind);
@@ -276,12 +286,14 @@ QMainWindow(parent)
    connect(actionShowSettings,SIGNAL(triggered()),this,SLOT(showSettings()));
    connect(actionHighlightEnable,SIGNAL(toggled(bool)),this,SLOT(toggleHighlightOn(bool)));
    connect(actionAutoIndent,SIGNAL(triggered()),this,SLOT(autoIndentCode()));
+   connect(actionIndentPhrase,SIGNAL(triggered()),this,SLOT(indentPhrase()));
    connect(actionFollowCursor,SIGNAL(triggered(bool)),this,SLOT(toggleAutoIndentOn(bool)));
    
    connect(actionZoomIn,SIGNAL(triggered()),this,SLOT(zoomIn()));
    connect(actionZoomOut,SIGNAL(triggered()),this,SLOT(zoomOut()));
    connect(actionFind,SIGNAL(triggered(bool)),this,SLOT(triggerFindReplace(bool)));
    connect(find,SIGNAL(hideRequest(bool)),this,SLOT(triggerFindReplace(bool)));
+   connect(find,SIGNAL(openFileRequest(QString,int)),this,SLOT(openFileAt(QString,int)));
    
    connect(inputZone, SIGNAL(unindentKeyStrokePressed()), this, SLOT(unindent()));
    
@@ -292,7 +304,9 @@ QMainWindow(parent)
    this->populateRecent();
    
    this->highlightTriggered = false;
+   QVector<indentKeyword> indentWords;
    fillIndentWords(&indentWords);
+   this->indenter = indentEngine(indentWords);
    
    //Draw trees?
    this->drawTrees = (settings->value("General/drawTrees",0).toInt() == 1)?true:false;
@@ -322,6 +336,9 @@ bool CamlDevWindow::startCamlProcess()
    QString camlProcessPath = settings->value("General/camlPath",(globalSettings->value("General/camlPath", "./caml/CamlLightToplevel").toString())).toString();
    camlProcess->start(camlProcessPath + " " + args);
 #endif
+   camlOutput.reset();
+   camlErrors.reset();
+   camlFrames.reset();
    return (camlProcess->state() == QProcess::Starting || camlProcess->state() == QProcess::Running);
 }
 
@@ -368,25 +385,10 @@ void CamlDevWindow::sendCaml()
    int startPos = 0;
    int endPos = 0;
    QTextCursor cursor = inputZone->textCursor();
-   QString text = inputZone->toPlainText();
    if(!cursor.hasSelection())
    {
       curPos = cursor.position();
-
-      //QString text = removeComments(text_r);
-      startPos = (text.lastIndexOf(";;",curPos)) + 2;
-      if(startPos == 1)
-      {
-         startPos = 0;
-      }
-      
-      endPos = (text.indexOf(";;",curPos)) + 2;
-      if(endPos == 1) endPos = text.length();
-      if(curPos == text.length()) //avoid sending the whole text
-      {
-         startPos = (text.lastIndexOf(";;",curPos - 2)) + 2;
-         if(startPos == 1) startPos = 0;
-      }
+      phrases->phraseAt(curPos, &startPos, &endPos);
    }
    else
    {
@@ -394,20 +396,35 @@ void CamlDevWindow::sendCaml()
       curPos = startPos;
       endPos = cursor.selectionEnd();
    }
-   QString toWrite = text.mid(startPos,endPos - startPos)  + "\n\0";
-   toWrite = removeComments(toWrite);
-   toWrite = removeUnusedLineBreaks(toWrite,true);
+   
+   //only the phrase is copied out of the document
+   QTextCursor phrase(inputZone->document());
+   phrase.setPosition(startPos);
+   phrase.setPosition(endPos, QTextCursor::KeepAnchor);
+   QString toWrite = phrase.selectedText();
+   toWrite.replace(QChar::ParagraphSeparator, '\n').replace(QChar::LineSeparator, '\n').replace(QChar::Nbsp, ' ');
+   toWrite += "\n\0";
+   toWrite = stripComments(toWrite, false);
+   //no leading line breaks; the phrase itself, string literals included, goes as it is
+   int firstChar = 0;
+   while(firstChar < toWrite.length() && toWrite.at(firstChar) == '\n')
+      firstChar++;
+   toWrite.remove(0, firstChar);
    
    if(prevCaml) {
       
       readCaml();
    }
+   //a frame left open before the prompt is not going to be closed by this phrase
+   QVector<outputFramer::piece> pieces;
+   camlFrames.endAtPrompt(&pieces);
+   appendFrames(pieces);
    appendOutput(toWrite,Qt::blue);
    
    camlProcess->write(toWrite.toLatin1());
    
-   int nextCurPos = text.indexOf(";;",curPos) + 2;
-   if(nextCurPos == 1){ nextCurPos = text.length();}
+   int nextCurPos = phrases->nextEnd(curPos);
+   if(nextCurPos < 0){ nextCurPos = inputZone->document()->characterCount() - 1;}
    
    cursor.setPosition(nextCurPos,QTextCursor::MoveAnchor);
    inputZone->setTextCursor(cursor);
@@ -415,8 +432,9 @@ void CamlDevWindow::sendCaml()
 
 void CamlDevWindow::readCamlErrors()
 {
-   QString stdErr = camlProcess->readAllStandardError();
-   stdErr = removeUnusedLineBreaks(stdErr,false);
+   QByteArray errors = camlProcess->readAllStandardError();
+   camlErrors.normalize(&errors);
+   QString stdErr = errors;
    if(stdErr != "") appendOutput(stdErr,Qt::red);
    
 }
@@ -424,60 +442,85 @@ void CamlDevWindow::readCamlErrors()
 void CamlDevWindow::readCaml()
 {
    
-   QString stdOut = camlProcess->readAllStandardOutput();
-   stdOut = removeUnusedLineBreaks(stdOut,false);
-   if(drawTrees)
+   QByteArray output = camlProcess->readAllStandardOutput();
+   camlOutput.normalize(&output);
+   QString stdOut = output;
+   if(!drawTrees)
    {
-      while(stdOut.indexOf("--LemonCamlCommand--") != -1)
-      {
-         int j = stdOut.indexOf("--LemonCamlCommand--"); //20
-         int p = stdOut.indexOf("--EndLemonCamlCommand--"); //23
-         if(p == -1)
-         {
-            appendOutput(tr("---LemonCaml error--- Unterminated command: not interpreted\n"), Qt::red);
-            stdOut = stdOut.mid(j + 20);
-         }
-         else
-         {
-            appendOutput(stdOut.left(j),this->palette().color(QPalette::WindowText));
-            QString cmd = stdOut.mid(j + 20, (p - j - 20));
-            QStringList cmdlist = parseBlockCommand(cmd);
+      if(stdOut != "") appendOutput(stdOut,this->palette().color(QPalette::WindowText));
+      return;
+   }
+   
+   //frames may be cut between two reads, the framer hands them out once whole
+   QVector<outputFramer::piece> pieces;
+   camlFrames.feed(stdOut, &pieces);
+   appendFrames(pieces);
+}
 
-            processCommandList(&cmdlist);
-            stdOut = stdOut.mid(p + 23);
-         }
-      }
-      while(stdOut.indexOf("--LemonTree--") != -1) //TODO: change this!!!! never leave such an absolute type name here; ask the user, instead.
+void CamlDevWindow::flushFrames()
+{
+   //what the framer holds back would otherwise wait for output that may never come
+   QVector<outputFramer::piece> pieces;
+   camlFrames.flush(&pieces);
+   appendFrames(pieces);
+}
+
+void CamlDevWindow::appendFrames(const QVector<outputFramer::piece> &pieces)
+{
+   for(int i = 0; i < pieces.count(); i++)
+   {
+      const outputFramer::piece &pc = pieces.at(i);
+      switch(pc.kind)
       {
-         int j = stdOut.indexOf("--LemonTree--"); // 17
-         int p = stdOut.indexOf("--EndLemonTree--"); //20
-         if(p == -1)
-         {
+         case outputFramer::Command:
+            processCommandFrame(pc.text);
+            break;
+         case outputFramer::Tree:
+            processTreeFrame(pc.text);
+            break;
+         case outputFramer::UnterminatedCommand:
+            appendOutput(tr("---LemonCaml error--- Unterminated command: not interpreted\n"), Qt::red);
+            appendOutput(pc.text,this->palette().color(QPalette::WindowText));
+            break;
+         case outputFramer::UnterminatedTree:
             appendOutput(tr("---LemonCaml error--- Unterminated tree: not drawn\n"), Qt::red);
-            stdOut = stdOut.mid(j + 17);  
-         }
-         else
-         {
-            appendOutput(stdOut.left(j),this->palette().color(QPalette::WindowText));
-            QString arb = stdOut.mid(j + 13, (p - j - 13));
-            int k = arb.indexOf('(');
-            if(k != -1)
-            {
-               QString arbString = arb.mid(k);
-               treeParser* tp = new treeParser();
-               QImage* img = tp->parseTree(arbString);
-               QTextCursor cursor = outputZone->textCursor();
-               cursor.insertImage((*img), QString(this->graphCount));
-               outputZone->insertPlainText("\n");
-               this->graphCount++;
-            }
-            stdOut = stdOut.mid(p + 16);
-         }
-         
+            appendOutput(pc.text,this->palette().color(QPalette::WindowText));
+            break;
+         default:
+            appendOutput(pc.text,this->palette().color(QPalette::WindowText));
+            break;
       }
    }
-   if(stdOut != "") appendOutput(stdOut,this->palette().color(QPalette::WindowText));
-   
+}
+
+void CamlDevWindow::processCommandFrame(const QString &frame)
+{
+   blockCommand cmd;
+   if(cmd.parse(QStringRef(&frame)))
+   {
+      QStringList cmdlist = cmd.toStringList();
+      processCommandList(&cmdlist);
+   }
+   else if(cmd.error() == blockCommand::UnterminatedString)
+      appendOutput(tr("---LemonCaml error--- Malformed command: unterminated string at character %1\n").arg(cmd.errorPosition()), Qt::red);
+   else
+      appendOutput(tr("---LemonCaml error--- Malformed command: dangling backslash at character %1\n").arg(cmd.errorPosition()), Qt::red);
+}
+
+void CamlDevWindow::processTreeFrame(const QString &frame)
+{
+   //TODO: change this!!!! never leave such an absolute type name here; ask the user, instead.
+   int k = frame.indexOf('(');
+   if(k != -1)
+   {
+      QString arbString = frame.mid(k);
+      treeParser* tp = new treeParser();
+      QImage* img = tp->parseTree(arbString);
+      QTextCursor cursor = outputZone->textCursor();
+      cursor.insertImage((*img), QString(this->graphCount));
+      outputZone->insertPlainText("\n");
+      this->graphCount++;
+   }
 }
 
 void CamlDevWindow::camlOK()
@@ -495,6 +538,7 @@ void CamlDevWindow::interruptCaml()
    if(camlProcess->state() == QProcess::Running)
    {
 #ifndef WIN32
+      flushFrames(); //an interrupted printer never closes its frame
       kill(camlProcess->pid(), SIGINT);
 #else
    
@@ -544,6 +588,7 @@ bool CamlDevWindow::saveFile(QString file)
    
    f.write(output.toUtf8());
    f.close();
+   inputZone->document()->setModified(false);
    this->setWindowTitle(this->programTitle + " - " + f.fileName());
    this->unsavedChanges = false;
    return true;
@@ -587,6 +632,25 @@ void CamlDevWindow::openFile(QString file)
    
 }
 
+void CamlDevWindow::openFileAt(QString file, int line)
+{
+   //e.g. a result of "Find in files"
+   if(QFileInfo(file) != QFileInfo(currentFile))
+   {
+      openFile(file);
+      if(QFileInfo(file) != QFileInfo(currentFile)) //not opened, or the user kept the current file
+         return;
+   }
+   
+   QTextBlock block = inputZone->document()->findBlockByNumber(line);
+   if(block.isValid())
+   {
+      inputZone->setTextCursor(QTextCursor(block));
+      inputZone->ensureCursorVisible();
+   }
+   inputZone->setFocus();
+}
+
 void CamlDevWindow::appendOutput(QString str, QColor color)
 {
    QTextCursor tc = outputZone->textCursor();
@@ -602,7 +666,8 @@ void CamlDevWindow::appendOutput(QString str, QColor color)
 
 void CamlDevWindow::textChanged()
 {
-   if(!this->unsavedChanges && !highlightTriggered)
+   //formatting changes (e.g. from lazy highlighting) also end up here, but do not modify the document
+   if(!this->unsavedChanges && !highlightTriggered && inputZone->document()->isModified())
    {
       this->unsavedChanges = true;
       this->setWindowTitle(this->windowTitle() + " (*)");
@@ -692,17 +757,16 @@ void CamlDevWindow::showSettings()
 {
    CamlDevSettings s(this, this->settings, this->globalSettings);
    s.exec();
+   bool drewTrees = this->drawTrees;
    this->drawTrees = (settings->value("General/drawTrees",0).toInt() == 1)?true:false;
+   if(drawTrees != drewTrees)
+      flushFrames();
    this->generateRecentMenu();
    this->populateRecent();
    
-   this->highlightTriggered = true; //do not account this setting change for an actual text change
-   hilit->setDocument(NULL);
+   //a single rehighlight, and none at all if the colors did not change
    this->hilit->updateColorSettings();
    
-   this->highlightTriggered = true;
-   hilit->setDocument(this->actionHighlightEnable->isChecked() ? inputZone->document() : 0);
-   
 }
 
 void CamlDevWindow::zoomIn()
@@ -961,15 +1025,99 @@ void CamlDevWindow::autoLoadML(QString location)
    camlProcess->write(built.toLatin1());
 }
 
+static int leadingWhitespace(const QString &line)
+{
+   int i = 0;
+   while(i < line.length() && (line.at(i) == '\t' || line.at(i) == ' '))
+      i++;
+   return i;
+}
+
+void CamlDevWindow::reindentBlocks(int firstBlock, int lastBlock, bool keepFirstIndent)
+{
+   QTextDocument *doc = inputZone->document();
+   QTextBlock first = doc->findBlockByNumber(firstBlock);
+   
+   QStringList lines;
+   for(QTextBlock b = first; b.isValid() && b.blockNumber() <= lastBlock; b = b.next())
+      lines << b.text();
+   if(lines.isEmpty())
+      return;
+   
+   //the first line may keep its indentation, the following ones are indented relatively to it
+   QString code = removeIndent(lines.join("\n"));
+   QString firstIndent;
+   int tabs = 0;
+   if(keepFirstIndent)
+   {
+      firstIndent = lines.first().left(leadingWhitespace(lines.first()));
+      tabs = firstIndent.count('\t');
+      code.prepend(QString(tabs, '\t'));
+   }
+   QString result = keepFirstIndent ? indentCode(code, &indenter, true) : indentCodeConcurrently(code, &indenter);
+   QStringList indented = result.split('\n', QString::KeepEmptyParts);
+   
+   //the indenter only counts tabs: the spaces of the first line go back where its tabs are
+   if(firstIndent != QString(tabs, '\t'))
+   {
+      indented[0] = firstIndent + indented.at(0).mid(leadingWhitespace(indented.at(0)));
+      QString tabIndent(tabs, '\t');
+      for(int i = 1; i < indented.count(); i++)
+      {
+         if(!indented.at(i).trimmed().isEmpty() && indented.at(i).startsWith(tabIndent))
+            indented[i].replace(0, tabs, firstIndent);
+      }
+   }
+   
+   //only the leading whitespace that changed is rewritten: the undo stack, the
+   //cursor and the highlighting of the untouched lines are left alone
+   QTextCursor cursor(doc);
+   cursor.beginEditBlock();
+   QTextBlock b = first;
+   for(int i = 0; i < indented.count() && b.isValid(); i++, b = b.next())
+   {
+      QString text = b.text();
+      int oldLength = leadingWhitespace(text);
+      int newLength = leadingWhitespace(indented.at(i));
+      if(text.leftRef(oldLength) == indented.at(i).leftRef(newLength))
+         continue;
+      cursor.setPosition(b.position());
+      cursor.setPosition(b.position() + oldLength, QTextCursor::KeepAnchor);
+      cursor.insertText(indented.at(i).left(newLength));
+   }
+   cursor.endEditBlock();
+}
+
 void CamlDevWindow::autoIndentCode()
 {
-   QString code = inputZone->toPlainText();
-   QString result = removeIndent(code);
-   QString indentedCode = indentCode(result, &indentWords, false); //do not calculate any pre-indent: we should be starting from zero!
+   QTextCursor cursor = inputZone->textCursor();
+   if(cursor.hasSelection())
+   {
+      QTextDocument *doc = inputZone->document();
+      int firstBlock = doc->findBlock(cursor.selectionStart()).blockNumber();
+      QTextBlock last = doc->findBlock(cursor.selectionEnd());
+      if(last.position() == cursor.selectionEnd() && last.blockNumber() > firstBlock)
+         last = last.previous(); //a selection of whole lines ends at the start of the next one
+      reindentBlocks(firstBlock, last.blockNumber(), true);
+   }
+   else
+      reindentBlocks(0, inputZone->document()->blockCount() - 1, false); //do not calculate any pre-indent: we should be starting from zero!
+}
+
+void CamlDevWindow::indentPhrase()
+{
+   int startPos = 0;
+   int endPos = 0;
+   phrases->phraseAt(inputZone->textCursor().position(), &startPos, &endPos);
    
-   inputZone->selectAll();
+   QTextDocument *doc = inputZone->document();
+   QTextBlock first = doc->findBlock(startPos);
+   int lastBlock = doc->findBlock(qMax(startPos, endPos - 1)).blockNumber();
+   if(first.text().mid(startPos - first.position()).trimmed().isEmpty() && first.blockNumber() < lastBlock)
+      first = first.next(); //the previous ";;" ends its line
    
-   inputZone->insertPlainText(indentedCode);
+   //a phrase starting in the middle of a line leaves that line where it is
+   reindentBlocks(first.blockNumber(), lastBlock, first.position() < startPos);
 }
 
 void CamlDevWindow::handleLineBreak()
@@ -982,7 +1130,7 @@ void CamlDevWindow::handleLineBreak()
    QString beg = line.left(cursor.positionInBlock());
    QString end = line.mid(cursor.positionInBlock());
    
-   toAppend = indentCode(beg + "\n" + end, &indentWords, true);
+   toAppend = indentCode(beg + "\n" + end, &indenter, true);
    
    cursor.select(QTextCursor::LineUnderCursor);
    inputZone->setTextCursor(cursor);
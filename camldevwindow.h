@@ -39,6 +39,7 @@
 #include "camldevsettings.h"
 #include "common.h"
 #include "findreplace.h"
+#include "phraseindex.h"
 
 #ifndef WIN32
 #include <unistd.h>
@@ -82,6 +83,7 @@ private:
    QAction *actionShowSettings;
    QAction *actionClearOutput;
    QAction *actionAutoIndent;
+   QAction *actionIndentPhrase;
    QAction *actionFollowCursor;
    QAction *actionUndo;
    QAction *actionRedo;
@@ -103,10 +105,14 @@ private:
    QMenu *menuHelp;
    QMenu *menuRecent;
    QProcess *camlProcess;
+   outputNormalizer camlOutput;
+   outputNormalizer camlErrors;
+   outputFramer camlFrames;
    QSettings *settings;
    QSettings *globalSettings;
    QPrinter *printer;
    highlighter *hilit;
+   phraseIndex *phrases;
    QString cwd;
    void closeEvent(QCloseEvent *event);
    void resizeEvent(QResizeEvent *event);
@@ -120,11 +126,16 @@ private:
    void processSubstituteTree(QStringList *commands);
    void processCommandList(QStringList *commands);
    void processRegisterTreeType(QStringList *commands);
+   void processCommandFrame(const QString &frame);
+   void processTreeFrame(const QString &frame);
+   void appendFrames(const QVector<outputFramer::piece> &pieces);
+   void flushFrames();
    QStringList treevars;
    QStringList treevalues;
    void autoLoadML(QString location);
+   void reindentBlocks(int firstBlock, int lastBlock, bool keepFirstIndent);
    bool drawTrees;
-   QVector<indentKeyword> indentWords;
+   indentEngine indenter;
    findReplace *find;
    QVBoxLayout *centralBox;
    
@@ -156,9 +167,11 @@ public slots:
    void toggleHighlightOn(bool doHighlight);
    void toggleAutoIndentOn(bool doIndent);
    void autoIndentCode();
+   void indentPhrase();
    void handleLineBreak();
    void unindent();
    void triggerFindReplace(bool show);
+   void openFileAt(QString file, int line);
    
 };
 
@@ -0,0 +1,386 @@
+// camllexer.cpp - Caml lexer used by the syntax highlighter
+// This file is part of LemonCaml - Copyright (C) 2012-2014 Corentin FERRY
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "camllexer.h"
+#include "keywords_table.h"
+
+static inline bool isWordChar(QChar c)
+{
+   return c.isLetterOrNumber() || c == '_';
+}
+
+/* Both hashes must stay in sync with genkeywords.awk, which picks the
+ * bucket multipliers so that no two built-in keywords share a slot. */
+static inline unsigned int foldKeyword(const QChar *s, int len)
+{
+   unsigned int b = 0;
+   for(int i = 0; i < len; i++)
+      b = (b * 131 + s[i].unicode()) & 0xFFFFFF;
+   return b;
+}
+
+static int lookupBuiltinKeyword(const QChar *s, int len)
+{
+   unsigned int b = foldKeyword(s, len);
+   unsigned int k = builtinKeywordMultipliers[b % builtinKeywordBuckets];
+   const builtinKeyword &kw = builtinKeywords[((b * k) & 0xFFFFFF) >> (24 - builtinKeywordBits)];
+
+   if(kw.length != len)
+      return -1;
+   for(int i = 0; i < len; i++)
+   {
+      if(s[i].unicode() != (uchar)kw.word[i])
+         return -1;
+   }
+   return kw.construct;
+}
+
+static inline void addToken(QVector<camlToken> *tokens, int start, int length, int construct)
+{
+   if(tokens != NULL && length > 0)
+   {
+      camlToken tok;
+      tok.start = start;
+      tok.length = length;
+      tok.construct = construct;
+      tokens->append(tok);
+   }
+}
+
+int camlLexer::charLiteralLength(const QString &text, int pos, int len)
+{
+   //`c`, or an escape such as `\n`, `\`` or `\123`; 0 when this is not a character literal
+   if(pos + 2 < len && text.at(pos + 1) != '\\' && text.at(pos + 2) == '`')
+      return 3;
+   if(pos + 1 < len && text.at(pos + 1) == '\\')
+   {
+      for(int end = pos + 3; end < len && end <= pos + 5; end++)
+      {
+         if(text.at(end) == '`')
+            return end - pos + 1;
+      }
+   }
+   return 0;
+}
+
+camlLexer::camlLexer()
+{
+   //start from the built-in operators, the built-in identifiers are looked up directly
+   for(int i = 0; i < builtinOperatorCount; i++)
+   {
+      OperatorRule op;
+      op.pattern = QString::fromLatin1(builtinOperators[i].word, builtinOperators[i].length);
+      op.construct = builtinOperators[i].construct;
+      insertOperator(op);
+   }
+}
+
+void camlLexer::loadKeywords(QStringList *lst)
+{
+   //the runtime keywords file only overrides or extends the built-in keywords
+   int len = lst->count();
+
+   for(int i = 0; i < len; i++)
+   {
+      if(lst->at(i).at(0) == '#') //comment
+         continue;
+
+      QStringList spl = lst->at(i).split(";", QString::SkipEmptyParts);
+      if(spl.count() == 2)
+      {
+         int construct = spl[1].toInt();
+
+         //plain identifiers go to the hash table, anything else is matched literally
+         bool isIdentifier = true;
+         for(int j = 0; j < spl[0].length() && isIdentifier; j++)
+            isIdentifier = isWordChar(spl[0].at(j));
+
+         if(isIdentifier)
+         {
+            if(lookupBuiltinKeyword(spl[0].constData(), spl[0].length()) != construct)
+               keywords.insert(spl[0], construct);
+         }
+         else
+         {
+            OperatorRule op;
+            op.pattern = spl[0];
+            op.construct = construct;
+            insertOperator(op);
+         }
+      }
+
+   }
+
+}
+
+void camlLexer::insertOperator(const OperatorRule &op)
+{
+   for(int j = 0; j < operators.count(); j++)
+   {
+      if(operators.at(j).pattern == op.pattern)
+      {
+         operators[j].construct = op.construct;
+         return;
+      }
+   }
+
+   //longest operators first, so that "||" wins over a would-be "|"
+   int j = 0;
+   while(j < operators.count() && operators.at(j).pattern.length() >= op.pattern.length())
+      j++;
+   operators.insert(j, op);
+}
+
+int camlLexer::lex(const QString &text, int state, QVector<camlToken> *tokens, QVector<int> *phraseEnds) const
+{
+   int len = text.length();
+   int start = 0;
+   int pos = 0;
+   
+   int mode = (state < 0) ? 0 : (state & ModeMask);
+   bool stringInComment = (state >= 0) && (state & StringInComment);
+   int declaration = (state < 0) ? NoDeclaration : ((state >> DeclarationShift) & DeclarationMask);
+   int localLets = (state < 0) ? 0 : ((state >> LocalLetShift) & LocalLetMask);
+   int depth = (state < 0) ? 0 : (state >> DepthShift);
+   bool topLevel = true; //at the start of the line, or right after ";;"
+
+   if(tokens != NULL)
+      tokens->clear();
+   if(phraseEnds != NULL)
+      phraseEnds->clear();
+
+   while (pos < len) {
+      switch (mode) {
+         case InComment:
+            while (pos < len) {
+               QChar c = text.at(pos);
+               if (stringInComment) {
+                  //"*)" does not close anything inside a string
+                  if (c == '\\')
+                     pos += 2;
+                  else {
+                     if (c == '"')
+                        stringInComment = false;
+                     ++pos;
+                  }
+               } else if (c == '(' && pos + 1 < len && text.at(pos + 1) == '*') {
+                  if (depth < MaxCommentDepth)
+                     ++depth;
+                  pos += 2;
+               } else if (c == '*' && pos + 1 < len && text.at(pos + 1) == ')') {
+                  pos += 2;
+                  if (--depth == 0) {
+                     mode = 0;
+                     break;
+                  }
+               } else {
+                  if (c == '"')
+                     stringInComment = true;
+                  ++pos;
+               }
+            }
+            pos = qMin(pos, len);
+            addToken(tokens, start, pos - start, Comment);
+            break;
+         case InString:
+            while (pos < len) {
+               if (text.at(pos) == '\\') {
+                  pos += 2; //an escape at the end of a line consumes the line break
+               } else if (text.at(pos) == '"') {
+                  pos += 1;
+                  mode = 0;
+                  break;
+               } else {
+                  ++pos;
+               }
+            }
+            pos = qMin(pos, len);
+            addToken(tokens, start, pos - start, String);
+            break;
+         case InPreprocessor:
+            while (pos < len) {
+               if (text.at(pos) == ';' && pos + 1 < len && text.at(pos + 1) == ';') {
+                  pos += 2;
+                  mode = 0;
+                  if (phraseEnds != NULL)
+                     phraseEnds->append(pos);
+                  break;
+               } else {
+                  ++pos;
+               }
+            }
+            addToken(tokens, start, pos - start, Preprocessor);
+            break;
+         default:
+            while (pos < len) {
+               QChar c = text.at(pos);
+               if (c == '(' && pos + 1 < len && text.at(pos + 1) == '*') {
+                  mode = InComment;
+                  depth = 1;
+                  start = pos;
+                  pos += 2;
+                  break;
+               } else if (c == '"') {
+                  mode = InString;
+                  start = pos;
+                  ++pos;
+                  break;
+               } else if (pos == 0 && c == '#') {
+                  mode = InPreprocessor;
+                  start = pos;
+                  ++pos;
+                  break;
+               } else if (c == '`') {
+                  //character literals never span lines, a lone backquote is left alone
+                  int charLen = charLiteralLength(text, pos, len);
+                  addToken(tokens, pos, charLen, Char);
+                  pos += (charLen > 0) ? charLen : 1;
+               } else if (isWordChar(c)) {
+                  pos = lexWord(text, pos, len, topLevel, &declaration, &localLets, tokens);
+                  topLevel = false;
+               } else if (c == ';' && pos + 1 < len && text.at(pos + 1) == ';') {
+                  declaration = NoDeclaration;
+                  localLets = 0;
+                  topLevel = true;
+                  pos += 2;
+                  if (phraseEnds != NULL)
+                     phraseEnds->append(pos);
+               } else {
+                  if (!c.isSpace()) {
+                     topLevel = false;
+                     if (declaration == LetName)
+                        declaration = LetBody; //a pattern such as "let (a, b) = ...", nothing to record
+                     else if (declaration == ExceptionName)
+                        declaration = NoDeclaration;
+                     else if (c == '=' && declaration == TypeEquals)
+                        declaration = TypeConstructor;
+                     else if (c == '|' && declaration == TypeBody)
+                        declaration = TypeConstructor;
+                     else if (declaration == TypeConstructor && c != '|')
+                        declaration = TypeBody; //"==", records and such have no constructors
+                  }
+                  pos += (tokens != NULL ? matchOperator(text, pos, len, tokens) : 1);
+               }
+            }
+            break;
+      }
+   }
+
+   if (mode == 0 && declaration == NoDeclaration)
+      return NormalState;
+   return mode | (stringInComment ? StringInComment : 0) | (declaration << DeclarationShift)
+          | (localLets << LocalLetShift) | (depth << DepthShift);
+}
+
+int camlLexer::matchOperator(const QString &text, int pos, int len, QVector<camlToken> *tokens) const
+{
+   //returns how many characters were consumed, always at least one
+   QChar c = text.at(pos);
+   for(int i = 0; i < operators.count(); i++)
+   {
+      const QString &op = operators.at(i).pattern;
+      int opLen = op.length();
+      if(op.at(0) != c || opLen > len - pos || text.midRef(pos, opLen) != op)
+         continue;
+      if(isWordChar(op.at(opLen - 1)) && pos + opLen < len && isWordChar(text.at(pos + opLen)))
+         continue;
+      addToken(tokens, pos, opLen, operators.at(i).construct);
+      return opLen;
+   }
+   return 1;
+}
+
+int camlLexer::lexWord(const QString &text, int pos, int len, bool topLevel, int *declaration, int *localLets, QVector<camlToken> *tokens) const
+{
+   //returns the end of the word
+   int end = pos + 1;
+   while(end < len && isWordChar(text.at(end)))
+      ++end;
+   
+   QStringRef word = text.midRef(pos, end - pos);
+   if(text.at(pos).isDigit())
+      return end;
+   
+   //binding occurrences first: they are recorded even in the state-only mode
+   //a line start is only a top-level position out of any declaration, a local "let" may begin a line
+   int defined = -1;
+   bool declaring = topLevel && *declaration == NoDeclaration;
+   if(declaring && word == QLatin1String("let"))
+      *declaration = LetName;
+   else if(declaring && word == QLatin1String("type"))
+      *declaration = TypeName;
+   else if(declaring && word == QLatin1String("exception"))
+      *declaration = ExceptionName;
+   else if(*declaration == LetBody && word == QLatin1String("let"))
+   {
+      if(*localLets < LocalLetMask)
+         ++*localLets;
+   }
+   else if(*declaration == LetBody && word == QLatin1String("in"))
+   {
+      if(*localLets > 0)
+         --*localLets;
+   }
+   else if(word == QLatin1String("and"))
+   {
+      if(*declaration == TypeEquals || *declaration == TypeConstructor || *declaration == TypeBody)
+         *declaration = TypeName;
+      else if(*declaration == LetBody && *localLets == 0)
+         *declaration = LetName;
+   }
+   else if(*declaration == LetName && word != QLatin1String("rec"))
+   {
+      defined = DefinedFunction;
+      *declaration = LetBody;
+   }
+   else if(*declaration == TypeName && !(pos > 0 && text.at(pos - 1) == '\''))
+   {
+      defined = DefinedType;
+      *declaration = TypeEquals;
+   }
+   else if(*declaration == TypeConstructor)
+   {
+      defined = DefinedConstructor;
+      *declaration = TypeBody;
+   }
+   else if(*declaration == ExceptionName)
+   {
+      defined = DefinedConstructor;
+      *declaration = NoDeclaration;
+   }
+   
+   if(tokens == NULL || word == QLatin1String("_"))
+      return end;
+   if(defined >= 0)
+   {
+      addToken(tokens, pos, end - pos, defined);
+      return end;
+   }
+   
+   int construct = -1;
+   if(!keywords.isEmpty())
+   {
+      //no copy here: the key only points into the block text
+      QHash<QString, int>::const_iterator kw = keywords.constFind(QString::fromRawData(text.constData() + pos, end - pos));
+      if(kw != keywords.constEnd())
+         construct = kw.value();
+   }
+   if(construct < 0)
+      construct = lookupBuiltinKeyword(text.constData() + pos, end - pos);
+   
+   addToken(tokens, pos, end - pos, construct >= 0 ? construct : (int)Identifier);
+   return end;
+}
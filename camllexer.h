@@ -0,0 +1,107 @@
+// camllexer.h - Caml lexer used by the syntax highlighter
+// This file is part of LemonCaml - Copyright (C) 2012-2014 Corentin FERRY
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef CAMLLEXER_H
+#define CAMLLEXER_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+
+struct camlToken {
+   int start;
+   int length;
+   int construct; //a highlighter::Construct
+};
+
+/* The lexer only reads its keyword tables once they are loaded, so a
+ * single instance may be shared by the GUI thread and worker threads. */
+class camlLexer
+{
+public:
+   enum TokenClass { //numbered like highlighter::Construct
+      Comment = 2,
+      Preprocessor = 3,
+      String = 5,
+      Char = 6,
+      DefinedFunction = 10, //names bound by a top-level declaration
+      DefinedType = 11,
+      DefinedConstructor = 12,
+      Identifier = 13 //any other identifier, resolved by the highlighter
+   };
+
+   /* The state at the end of a line is what QSyntaxHighlighter stores per
+    * block: -1 outside of anything, otherwise a mode in the low bits, whether
+    * a string is open inside a comment, where we are in a top-level
+    * declaration, how many local "let"s its body has open, and the comment
+    * nesting depth. */
+   enum State {
+      NormalState = -1,
+      InComment = 1,
+      InString = 2,
+      InPreprocessor = 3
+   };
+   
+   enum {
+      ModeMask = 0x3,
+      StringInComment = 0x4,
+      DeclarationShift = 3,
+      DeclarationMask = 0x7,
+      LocalLetShift = 6,
+      LocalLetMask = 0xF, //saturates: deeper "let ... in" are not told apart
+      DepthShift = 10,
+      MaxCommentDepth = 0xFFF
+   };
+
+   camlLexer();
+   void loadKeywords(QStringList *lst);
+
+   /* Returns the state at the end of the line; with no token list, only the
+    * state is computed. phraseEnds gets the positions just past each ";;"
+    * that ends a phrase, out of comments and strings. */
+   int lex(const QString &text, int state, QVector<camlToken> *tokens, QVector<int> *phraseEnds = NULL) const;
+   
+   //length of the character literal at pos (`c`, `\n`, `\123`...), 0 if the backquote does not start one
+   static int charLiteralLength(const QString &text, int pos, int len);
+
+private:
+   struct OperatorRule //keywords that are not plain identifiers, such as "->" or "||"
+   {
+      QString pattern;
+      int construct;
+   };
+
+   //what the next words of a top-level declaration bind
+   enum Declaration {
+      NoDeclaration,
+      LetName, //after "let", "let rec" or "and"
+      LetBody, //"let ... in" inside it are counted, their "and" binds nothing
+      TypeName, //after "type" or "and", type variables are skipped
+      TypeEquals,
+      TypeConstructor, //after "=" or "|"
+      TypeBody,
+      ExceptionName
+   };
+
+   QHash<QString, int> keywords; //overrides from the runtime keywords file
+   QVector<OperatorRule> operators;
+   void insertOperator(const OperatorRule &op);
+   int matchOperator(const QString &text, int pos, int len, QVector<camlToken> *tokens) const;
+   int lexWord(const QString &text, int pos, int len, bool topLevel, int *declaration, int *localLets, QVector<camlToken> *tokens) const;
+};
+
+#endif
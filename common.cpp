@@ -14,7 +14,15 @@
 // You should have received a copy of the GNU General Public License
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <QHash>
+#include <QPair>
+#include <QVarLengthArray>
+#include <QThread>
+#include <QtConcurrent>
+#include <QMutex>
+#include <QMutexLocker>
 #include "common.h"
+#include "camllexer.h"
 
 int* colorFromString(QString str)
 {
@@ -33,136 +41,316 @@ int* colorFromString(QString str)
    return ret;
 }
 
-QString removeComments(QString baseStr)
+QString stripComments(const QString &code, bool keepLineBreaks, QVector<int> *phraseEnds)
 {
-   int pos_l = 0;
-   int pos_r = 0;
-   QString str = baseStr;
-   while(str.indexOf("(*") != -1 || str.indexOf("*)") != -1)
+   //one forward pass: strings and character literals are copied as they are, comments (nested or not) are dropped
+   int len = code.length();
+   const QChar *in = code.constData();
+   QString result(len, Qt::Uninitialized); //never grows: a comment is at least as long as the space it may leave
+   QChar *out = result.data();
+   int n = 0;
+   int depth = 0;
+   bool inString = false; //strings count inside comments too, "*)" in one closes nothing
+   bool phraseEnded = false; //a ";;" was seen on this line, out of comments and strings
+   
+   auto put = [&](QChar c) {
+      if(depth == 0)
+         out[n++] = c;
+      else if(keepLineBreaks && c == '\n')
+         out[n++] = c;
+   };
+   
+   int i = 0;
+   while(i < len)
    {
-      pos_l = str.indexOf("(*");
-      if(pos_l < 0) pos_l = 0;
-      pos_r = str.indexOf("*)", pos_l); //looking for a closing comment
-      if(pos_r >= 0) pos_r += 2;
-      else pos_r = str.length() - 1;
-      QString tmpstr = str.left(pos_l) + str.mid(pos_r);
-      str = tmpstr;
+      QChar c = in[i];
+      if(inString)
+      {
+         if(c == '\\' && i + 1 < len)
+         {
+            put(c);
+            put(in[i + 1]);
+            if(in[i + 1] == '\n')
+               phraseEnded = false;
+            i += 2;
+            continue;
+         }
+         if(c == '"')
+            inString = false;
+         else if(c == '\n')
+            phraseEnded = false;
+         put(c);
+         i++;
+      }
+      else if(c == '(' && i + 1 < len && in[i + 1] == '*')
+      {
+         //a comment separates tokens, "let(*c*)x" is not "letx"
+         if(depth == 0 && !keepLineBreaks && n > 0 && !out[n - 1].isSpace())
+            out[n++] = ' ';
+         depth++;
+         i += 2;
+      }
+      else if(depth > 0 && c == '*' && i + 1 < len && in[i + 1] == ')')
+      {
+         depth--;
+         i += 2;
+      }
+      else if(c == '"')
+      {
+         inString = true;
+         put(c);
+         i++;
+      }
+      else if(c == '`' && depth == 0)
+      {
+         int charLen = qMax(1, camlLexer::charLiteralLength(code, i, len));
+         for(int j = 0; j < charLen; j++)
+         {
+            put(in[i + j]);
+            if(in[i + j] == '\n')
+               phraseEnded = false;
+         }
+         i += charLen;
+      }
+      else
+      {
+         if(depth == 0 && c == ';' && i + 1 < len && in[i + 1] == ';')
+            phraseEnded = true;
+         else if(c == '\n')
+         {
+            if(phraseEnds != NULL && phraseEnded && depth == 0)
+               phraseEnds->append(i);
+            phraseEnded = false;
+         }
+         put(c);
+         i++;
+      }
    }
-   return str;
+   
+   result.resize(n);
+   return result;
 }
 
-
-QString removeCommentsConservative(QString baseStr) //keeps the line breaks, used for indentation analysis purposes
+template <typename Char>
+int outputNormalizer::normalizeRaw(Char *data, int length)
 {
-   int pos_l = 0;
-   int pos_r = 0;
-   QString str = baseStr;
-   while(str.indexOf("(*") != -1 || str.indexOf("*)") != -1)
+   //returns the new length; the write position never passes the read position
+   int w = 0;
+   int spaces = 0;
+   for(int r = 0; r < length; r++)
    {
-      pos_l = str.indexOf("(*");
-      if(pos_l < 0) pos_l = 0;
-      pos_r = str.indexOf("*)", pos_l); //looking for a closing comment
-      if(pos_r >= 0) pos_r += 2;
-      else pos_r = str.length() - 1;
-
-      //count how many \n's in the comment
-      int brCount = str.mid(pos_l, pos_r - pos_l).count('\n');
-
-      QString equivCp = "";
-      for(int j = 0; j < brCount; j++)
+      Char c = data[r];
+      if(c == ' ')
+      {
+         spaces++;
+         continue;
+      }
+      if(c == '\n')
       {
-         equivCp += '\n';
+         spaces = 0;
+         if(!atLineStart)
+            data[w++] = c;
+         atLineStart = true;
+         continue;
       }
-      QString tmpstr = str.left(pos_l) + equivCp + str.mid(pos_r);
-      str = tmpstr;
+      for(; spaces > 0; spaces--)
+         data[w++] = ' ';
+      data[w++] = c;
+      atLineStart = false;
    }
-   return str;
+   pendingSpaces = spaces;
+   return w;
 }
 
-QString removeUnusedLineBreaks(QString str, bool isPersonalOutput)
+void outputNormalizer::normalize(QByteArray *chunk)
 {
-   if(isPersonalOutput)
-   {
-      while(str.startsWith("\n"))
-      {
-         str = str.right(str.length()-1);
-      }
-   }
-   while(str.indexOf(" \n") != -1 && str.indexOf("\n\n") != -1)
-   {
-      str = str.replace(" \n","\n",Qt::CaseInsensitive);
-      str = str.replace("\n\n","\n",Qt::CaseInsensitive);
-   }
-   return str;
+   if(pendingSpaces > 0)
+      chunk->prepend(QByteArray(pendingSpaces, ' '));
+   chunk->resize(normalizeRaw(chunk->data(), chunk->length()));
 }
 
-QStringList parseBlockCommand(QString cmd)
+void outputNormalizer::normalize(QString *chunk)
 {
-   QStringList blocks;
-   int pos = 0;
-   int start = 0;
-   bool escapeSequence = false;
-   bool inString = false;
-   while (pos < cmd.length())
+   if(pendingSpaces > 0)
+      chunk->prepend(QString(pendingSpaces, ' '));
+   chunk->resize(normalizeRaw(chunk->data(), chunk->length()));
+}
+
+static const QLatin1String commandStart("--LemonCamlCommand--");
+static const QLatin1String commandEnd("--EndLemonCamlCommand--");
+static const QLatin1String treeStart("--LemonTree--");
+static const QLatin1String treeEnd("--EndLemonTree--");
+
+static bool isMarkerStart(const QStringRef &rest, const QLatin1String &marker)
+{
+   //whether the end of a chunk may be cut in the middle of marker
+   return rest.length() < marker.size() && rest == QLatin1String(marker.data(), rest.length());
+}
+
+void outputFramer::add(QVector<piece> *pieces, Kind kind, const QString &text)
+{
+   if(kind == Text && text.isEmpty())
+      return;
+   piece p;
+   p.kind = kind;
+   p.text = text;
+   pieces->append(p);
+}
+
+void outputFramer::feed(const QString &chunk, QVector<piece> *pieces)
+{
+   buffer.append(chunk);
+   int pos = scanned;
+   int consumed = 0; //what is before it has been handed out
+   
+   while(true)
    {
-      if(escapeSequence)
+      if(frame == Text)
       {
-         escapeSequence = false;
-         QChar c = cmd[pos];
-         switch(c.toLatin1())
+         int k = buffer.indexOf(QLatin1String("--"), pos);
+         if(k < 0)
          {
-            case 'n':
-               cmd[pos] = '\n';
-               break;
-            case '"':
-               cmd[pos] = '"';
-               break;
-            case '\\':
-               cmd[pos] = '\\';
-               break;
-            
+            //a last '-' not scanned yet may be the start of a marker
+            pos = (buffer.length() > pos && buffer.endsWith('-')) ? buffer.length() - 1 : buffer.length();
+            add(pieces, Text, buffer.mid(consumed, pos - consumed));
+            consumed = pos;
+            break;
+         }
+         
+         QStringRef rest = buffer.midRef(k);
+         int markerLength = 0;
+         if(rest.startsWith(commandStart))
+         {
+            frame = Command;
+            markerLength = commandStart.size();
+         }
+         else if(rest.startsWith(treeStart))
+         {
+            frame = Tree;
+            markerLength = treeStart.size();
          }
-         cmd.remove(pos - 1, 1);
-         pos++;
+         else if(isMarkerStart(rest, commandStart) || isMarkerStart(rest, treeStart))
+         {
+            add(pieces, Text, buffer.mid(consumed, k - consumed));
+            consumed = pos = k;
+            break;
+         }
+         else
+         {
+            pos = k + 1;
+            continue;
+         }
+         
+         add(pieces, Text, buffer.mid(consumed, k - consumed));
+         consumed = pos = k + markerLength;
       }
       else
       {
-         if(cmd.at(pos) == '"' )
+         QLatin1String end = (frame == Command) ? commandEnd : treeEnd;
+         int k = buffer.indexOf(end, pos);
+         if(k >= 0)
          {
-            inString = (!inString);
+            add(pieces, frame, buffer.mid(consumed, k - consumed));
+            frame = Text;
+            consumed = pos = k + end.size();
+            continue;
          }
-         else if(cmd.at(pos) == '\\')
+         
+         if(buffer.length() - consumed > MaxFrameLength)
          {
-            escapeSequence = true;
+            //most likely a marker printed on its own, not a frame
+            add(pieces, (frame == Command) ? UnterminatedCommand : UnterminatedTree, buffer.mid(consumed));
+            frame = Text;
+            consumed = pos = buffer.length();
          }
-         else if(cmd.at(pos) == ' ' && !inString)
-         {
-            QString toInsert = cmd.mid(start, pos - start); //don't account the space
-            if(toInsert.startsWith("\"") && toInsert.endsWith("\""))
-            {
-               int len = toInsert.length() - 1;
-               toInsert = toInsert.left(len).mid(1);
-            }
-            blocks << toInsert; 
-            start = pos + 1;
-         }
-
+         else
+            pos = qMax(consumed, buffer.length() - end.size() + 1); //the end marker may be cut
+         break;
       }
-      pos++;
    }
    
-   //the last block
+   buffer.remove(0, consumed);
+   scanned = pos - consumed;
+}
+
+void outputFramer::flush(QVector<piece> *pieces)
+{
+   if(frame == Text)
+      add(pieces, Text, buffer);
+   else
+      add(pieces, (frame == Command) ? UnterminatedCommand : UnterminatedTree, buffer);
+   reset();
+}
+
+void outputFramer::endAtPrompt(QVector<piece> *pieces)
+{
+   if(frame != Text && buffer.endsWith(QLatin1String("\n#")))
+      flush(pieces);
+}
+
+bool blockCommand::parse(const QStringRef &cmd)
+{
+   int len = cmd.length();
+   const QChar *in = cmd.unicode();
+   text.resize(len); //never grows: escapes and quotes only shrink the command
+   QChar *out = text.data();
+   int n = 0;
+   arguments.clear();
+   err = NoError;
+   errPosition = -1;
    
-   QString toInsert = cmd.mid(start);
-   if(toInsert.startsWith("\"") && toInsert.endsWith("\""))
+   int argumentStart = -1; //in text, -1 between arguments
+   int stringStart = -1; //in cmd, -1 out of quotes
+   for(int i = 0; i < len; i++)
    {
-      int len = toInsert.length() - 1;
-      toInsert = toInsert.left(len).mid(1);
+      QChar c = in[i];
+      if(c == ' ' && stringStart < 0)
+      {
+         if(argumentStart >= 0)
+            arguments << qMakePair(argumentStart, n - argumentStart);
+         argumentStart = -1;
+         continue;
+      }
+      
+      if(argumentStart < 0)
+         argumentStart = n;
+      if(c == '"')
+      {
+         stringStart = (stringStart < 0) ? i : -1;
+         continue;
+      }
+      if(c == '\\')
+      {
+         if(i + 1 == len)
+         {
+            err = DanglingEscape;
+            errPosition = i;
+            break;
+         }
+         c = in[++i];
+         if(c == 'n')
+            c = '\n';
+      }
+      out[n++] = c;
    }
    
-   blocks << toInsert; 
-   
-   return blocks;
+   if(err == NoError && stringStart >= 0)
+   {
+      err = UnterminatedString;
+      errPosition = stringStart;
+   }
+   if(argumentStart >= 0)
+      arguments << qMakePair(argumentStart, n - argumentStart);
+   text.resize(n);
+   return err == NoError;
+}
+
+QStringList blockCommand::toStringList() const
+{
+   QStringList list;
+   for(int i = 0; i < arguments.count(); i++)
+      list << argument(i).toString();
+   return list;
 }
 
 int findNextDoubleCommaDot(int pos, QString str)
@@ -172,20 +360,208 @@ int findNextDoubleCommaDot(int pos, QString str)
 }
 
 
-QString indentCode(QString code, QVector<indentKeyword> *iw, bool calculatePreIndent)
+QRegularExpression cachedRegularExpression(const QString &pattern, QRegularExpression::PatternOptions options)
+{
+   static QMutex mutex;
+   static QHash<QPair<QString, int>, QRegularExpression> cache;
+   const int maxPatterns = 256; //find-as-you-type goes through many patterns, most are never used again
+   
+   QMutexLocker lock(&mutex);
+   QPair<QString, int> key(pattern, (int)options);
+   QHash<QPair<QString, int>, QRegularExpression>::const_iterator it = cache.constFind(key);
+   if(it != cache.constEnd())
+      return it.value();
+   
+   if(cache.count() >= maxPatterns)
+      cache.clear();
+   QRegularExpression re(pattern, options);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 4, 0)
+   re.optimize(); //JIT-compiles the pattern now rather than on its first few matches
+#endif
+   cache.insert(key, re);
+   return re;
+}
+
+static inline bool isIndentWordChar(QChar c)
+{
+   //what \w matched in the QRegExp indentation rules: letters and digits of any script, accented ones included
+   return c.isLetterOrNumber() || c == '_';
+}
+
+indentEngine::indentEngine(const QVector<indentKeyword> &keywords)
+{
+   for(int i = 0; i < keywords.count(); i++)
+   {
+      const indentKeyword &kw = keywords.at(i);
+      compiledRule rule;
+      rule.token = tokenId(kw.token);
+      rule.follow = tokenId(kw.follow);
+      rule.followAgain = tokenId(kw.followAgain);
+      rule.rule = kw.rule;
+      if(rule.token >= 0)
+         rules << rule;
+   }
+}
+
+int indentEngine::tokenId(const QString &token)
+{
+   if(token.isEmpty())
+      return -1;
+   
+   if(isIndentWordChar(token.at(0)))
+   {
+      QHash<QString, int>::const_iterator it = words.constFind(token);
+      if(it != words.constEnd())
+         return it.value();
+      words.insert(token, tokenCount);
+      return tokenCount++;
+   }
+   
+   for(int i = 0; i < symbols.count(); i++)
+   {
+      if(symbols.at(i).first == token)
+         return symbols.at(i).second;
+   }
+   int j = 0;
+   while(j < symbols.count() && symbols.at(j).first.length() >= token.length())
+      j++;
+   symbols.insert(j, qMakePair(token, tokenCount));
+   return tokenCount++;
+}
+
+lineIndent indentEngine::classify(const QString &line) const
+{
+   struct occurrence {
+      int token;
+      int start;
+   };
+   QVarLengthArray<occurrence, 64> found;
+   QVarLengthArray<int, 32> first(tokenCount);
+   QVarLengthArray<int, 32> count(tokenCount);
+   for(int t = 0; t < tokenCount; t++)
+   {
+      first[t] = -1;
+      count[t] = 0;
+   }
+   
+   //one pass: whole words and symbols, everything else is skipped
+   const QChar *text = line.constData();
+   int len = line.length();
+   int pos = 0;
+   while(pos < len)
+   {
+      int token = -1;
+      int start = pos;
+      int end = pos + 1;
+      if(isIndentWordChar(text[pos]))
+      {
+         while(end < len && isIndentWordChar(text[end]))
+            end++;
+         //no copy here: the key only points into the line
+         QHash<QString, int>::const_iterator it = words.constFind(QString::fromRawData(text + pos, end - pos));
+         if(it != words.constEnd())
+            token = it.value();
+      }
+      else
+      {
+         for(int i = 0; i < symbols.count(); i++)
+         {
+            const QString &symbol = symbols.at(i).first;
+            if(symbol.at(0) == text[pos] && line.midRef(pos, symbol.length()) == symbol)
+            {
+               token = symbols.at(i).second;
+               end = pos + symbol.length();
+               break;
+            }
+         }
+         if(text[pos] == ']' && pos > 0 && text[pos - 1] == '|')
+            start = pos - 1; //"|]" starts on the bar, which matters at the start of a line
+      }
+      
+      if(token >= 0)
+      {
+         occurrence o = { token, start };
+         found.append(o);
+         if(first[token] < 0)
+            first[token] = start;
+         count[token]++;
+      }
+      pos = end;
+   }
+   
+   lineIndent result = { 0, false, false, false };
+   for(int r = 0; r < rules.count(); r++)
+   {
+      const compiledRule &rule = rules.at(r);
+      int start = first[rule.token];
+      if(start < 0)
+         continue;
+      
+      int hits = count[rule.token];
+      if(rule.follow >= 0)
+      {
+         //"let ... =" counts once, when something follows the first "let"
+         int i = 0;
+         while(i < found.count() && !(found[i].token == rule.follow && found[i].start > start))
+            i++;
+         if(i == found.count())
+            continue;
+         if(rule.followAgain >= 0)
+         {
+            int followStart = found[i].start;
+            while(i < found.count() && !(found[i].token == rule.followAgain && found[i].start > followStart))
+               i++;
+            if(i == found.count())
+               continue;
+         }
+         hits = 1;
+      }
+      
+      switch(rule.rule)
+      {
+         case Increment:
+            result.relativeLevel += hits;
+            break;
+         case IDLine:
+            result.relativeLevel += hits;
+            if(start == 0) {
+               result.relativeLevel -= 1;
+               result.decrCurrentLine = true;
+            }
+            break;
+         case Decrement:
+            result.relativeLevel -= hits;
+            if(start == 0)
+               result.decrCurrentLine = true;
+            break;
+         case Reset:
+            result.relativeLevel = 0;
+            result.reset = true;
+            if(start == 0)
+               result.stripCurrentLine = true;
+            break;
+            
+         default:
+            break;
+      }
+   }
+   return result;
+}
+
+QString indentCode(QString code, const indentEngine *engine, bool calculatePreIndent)
 {
    int indentLevel = 0;
    
    if(calculatePreIndent)
    {
-      while(code.at(0) == '\t') //indent for the first line
+      while(code.startsWith('\t')) //indent for the first line
       {
          indentLevel++;
          code = code.mid(1);
       }
    }
    
-   QString cleanCode = removeCommentsConservative(code);
+   QString cleanCode = stripComments(code, true);
    
    QStringList separatedLines = code.split('\n', QString::KeepEmptyParts);
    QStringList treatedLines = cleanCode.split('\n', QString::KeepEmptyParts);
@@ -193,69 +569,31 @@ QString indentCode(QString code, QVector<indentKeyword> *iw, bool calculatePreIn
    QStringList result;
    for(int k = 0; k < separatedLines.count(); k++)
    {
-      QString line = treatedLines.at(k); //line without comments
       QString ind = separatedLines.at(k); //line with comments
       
       //indent the current line
-      for(int i = 0; i < indentLevel; i++)
-      {
-         ind.prepend("\t");
-      }
+      if(indentLevel > 0)
+         ind.prepend(QString(indentLevel, '\t'));
       
-      int relativeLevel = 0;
-      bool reset = false;
-      bool decrCurrentLine = false;
-         
-      foreach(indentKeyword kw, *iw)
+      //the line without comments, and NOT ind, as we don't count ANY inserted indentation
+      lineIndent li = engine->classify(treatedLines.at(k));
+      
+      if(li.stripCurrentLine)
       {
-         QRegExp expression(kw.pattern);
-         int index = expression.indexIn(line); //and NOT ind, as we don't count ANY inserted indentation
-
-         while (index >= 0) {
-            int length = expression.matchedLength();
-            switch(kw.rule)
-            {
-               case Increment:
-                  relativeLevel += 1;
-                  break;
-               case IDLine:
-                  relativeLevel += 1;
-                  if(index == 0) {
-                     relativeLevel -= 1;
-                     decrCurrentLine = true;
-                  }
-                  break;
-               case Decrement:
-                  relativeLevel -= 1;
-                  if(index == 0)
-                     decrCurrentLine = true;
-                  break;
-               case Reset:
-                  relativeLevel = 0;
-                  reset = true;
-                  if(index == 0) {
-                     while(ind.at(0) == '\t')
-                        ind = ind.mid(1);
-                  }
-                  break;
-                  
-               default:
-                  break;
-            }
-            index = expression.indexIn(line, index + length);
-         }
-
+         while(ind.startsWith('\t'))
+            ind = ind.mid(1);
       }
-
+      
+      int relativeLevel = li.relativeLevel;
       if(relativeLevel > 1)
          relativeLevel = 1;
       if(relativeLevel < -1)
          relativeLevel = -1;
-      if(reset)
+      if(li.reset)
          indentLevel = 0;
       else
          indentLevel += relativeLevel;
-      if(decrCurrentLine && ind.at(0) == '\t') //avoid decrementing that are not indented
+      if(li.decrCurrentLine && ind.startsWith('\t')) //avoid decrementing that are not indented
          ind = ind.mid(1);
       
       result << ind;
@@ -263,6 +601,45 @@ QString indentCode(QString code, QVector<indentKeyword> *iw, bool calculatePreIn
    return result.join("\n");   
 }
 
+struct phraseIndenter
+{
+   typedef QString result_type;
+   
+   const indentEngine *engine;
+   phraseIndenter(const indentEngine *engine) : engine(engine) {}
+   QString operator()(const QString &chunk) const
+   {
+      return indentCode(chunk, engine, false);
+   }
+};
+
+QString indentCodeConcurrently(const QString &code, const indentEngine *engine)
+{
+   //";;" brings the indentation back to zero, so the phrases can be indented apart
+   QVector<int> phraseEnds;
+   stripComments(code, true, &phraseEnds);
+   
+   //a few chunks per thread, not too small to be worth a task
+   const int minChunk = 16384;
+   int chunkLength = qMax(minChunk, code.length() / (4 * qMax(1, QThread::idealThreadCount())));
+   
+   QStringList chunks;
+   int start = 0;
+   for(int i = 0; i < phraseEnds.count(); i++)
+   {
+      if(phraseEnds.at(i) - start >= chunkLength)
+      {
+         chunks << code.mid(start, phraseEnds.at(i) - start);
+         start = phraseEnds.at(i) + 1; //the line break goes back in when joining
+      }
+   }
+   if(chunks.isEmpty())
+      return indentCode(code, engine, false);
+   chunks << code.mid(start);
+   
+   return QtConcurrent::blockingMapped<QStringList>(chunks, phraseIndenter(engine)).join("\n");
+}
+
 QString removeIndent(QString code)
 {
    QStringList separatedLines = code.split('\n', QString::KeepEmptyParts);
@@ -278,62 +655,40 @@ QString removeIndent(QString code)
    return result.join("\n");
 }
 
-void fillIndentWords(QVector<indentKeyword> *iw)
+static void addIndentKeyword(QVector<indentKeyword> *iw, const char *token, indentRule rule, const char *follow = "", const char *followAgain = "")
 {
-   QStringList triggers;
-   QList<indentRule> rules;
    indentKeyword kwd;
-   triggers << "\\blet\\b(.*)=((^((?!and).)*$)(\\band\\b(.*)=))*" 
-      << "\\btype\\b(.*)=" 
-      << "\\bin\\b" 
-      << "\\bwith\\b" 
-      << "\\(" 
-      << "\\)" 
-      << "\\{"
-      << "\\}"
-      << "\\bbegin\\b" 
-      << "\\bend\\b" 
-      << "\\[(\\|?)" 
-      << "(\\|?)\\]" 
-      << "\\bfor\\b(.*)\\bdo\\b" 
-      << "\\bwhile\\b(.*)\\bdo\\b" 
-      << "\\bdone\\b" 
-      << "\\btry\\b" 
-      << "\\bmatch\\b"
-      << "\\bif\\b"
-      << "\\bthen\\b"
-      << "\\band\\b(.*)="
-      << "\\band\\b(.*)=(.*)\\bin\\b"
-      << "\\bwhere\\b"
-      << ";;";
-      
-   rules << Increment //let = (and ... =)
-      << Increment //type = 
-      << Decrement //in
-      << Decrement //with : I don't put it since I can't determine where the matching stops. The same applies for the if/then/else construction (that's why there's a decrement for "then").
-      << Increment //(
-      << Decrement //)
-      << Increment //{
-      << Decrement //}
-      << Increment //begin
-      << Decrement //end
-      << Increment //[
-      << Decrement //]
-      << Increment //for do
-      << Increment //while do
-      << Decrement //done
-      << Increment //try
-      << Increment //match
-      << Increment //if
-      << Decrement //then
-      << IDLine //and
-      << Decrement //and in (to compensate let a = ... and b = .... in that counts twice)
-      << IDLine
-      << Reset; //;;
-   while(!rules.isEmpty())
-   {
-      kwd.pattern = triggers.takeFirst();
-      kwd.rule = rules.takeFirst();
-      (*iw) << kwd;
-   }
-}
\ No newline at end of file
+   kwd.token = QLatin1String(token);
+   kwd.follow = QLatin1String(follow);
+   kwd.followAgain = QLatin1String(followAgain);
+   kwd.rule = rule;
+   (*iw) << kwd;
+}
+
+void fillIndentWords(QVector<indentKeyword> *iw)
+{
+   //the order matters: ";;" resets whatever came before it
+   addIndentKeyword(iw, "let", Increment, "="); //let = (and ... =)
+   addIndentKeyword(iw, "type", Increment, "="); //type = 
+   addIndentKeyword(iw, "in", Decrement);
+   addIndentKeyword(iw, "with", Decrement); //with : I don't put it since I can't determine where the matching stops. The same applies for the if/then/else construction (that's why there's a decrement for "then").
+   addIndentKeyword(iw, "(", Increment);
+   addIndentKeyword(iw, ")", Decrement);
+   addIndentKeyword(iw, "{", Increment);
+   addIndentKeyword(iw, "}", Decrement);
+   addIndentKeyword(iw, "begin", Increment);
+   addIndentKeyword(iw, "end", Decrement);
+   addIndentKeyword(iw, "[", Increment); //[ and [|
+   addIndentKeyword(iw, "]", Decrement); //] and |]
+   addIndentKeyword(iw, "for", Increment, "do");
+   addIndentKeyword(iw, "while", Increment, "do");
+   addIndentKeyword(iw, "done", Decrement);
+   addIndentKeyword(iw, "try", Increment);
+   addIndentKeyword(iw, "match", Increment);
+   addIndentKeyword(iw, "if", Increment);
+   addIndentKeyword(iw, "then", Decrement);
+   addIndentKeyword(iw, "and", IDLine, "=");
+   addIndentKeyword(iw, "and", Decrement, "=", "in"); //and in (to compensate let a = ... and b = .... in that counts twice)
+   addIndentKeyword(iw, "where", IDLine);
+   addIndentKeyword(iw, ";;", Reset);
+}
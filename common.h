@@ -20,6 +20,10 @@
 #include <QString>
 #include <QStringList>
 #include <QDebug>
+#include <QRegularExpression>
+#include <QHash>
+#include <QVector>
+#include <QPair>
 
 enum indentRule {
    Increment,
@@ -28,20 +32,155 @@ enum indentRule {
    IDLine //increment what follows, decrement the current line if this keyword is the first to appear
 };
 
+/* A keyword such as "begin" or a symbol such as "(". With a follower, it
+ * only counts once per line, when the follower comes after it (and then
+ * followAgain after the follower), as in "let ... =". */
 struct indentKeyword {
-   QString pattern;
+   QString token;
+   QString follow;
+   QString followAgain;
    indentRule rule;
 };
 
+//what a line does to the indentation, before clamping
+struct lineIndent {
+   int relativeLevel;
+   bool reset;
+   bool decrCurrentLine;
+   bool stripCurrentLine; //";;" opens the line: it goes back to the margin
+};
+
+/* The indentation rules compiled into token ids: a line is classified in a
+ * single pass over its characters, whatever the number of rules. */
+class indentEngine
+{
+public:
+   indentEngine() {}
+   explicit indentEngine(const QVector<indentKeyword> &keywords);
+   lineIndent classify(const QString &line) const;
+   
+private:
+   struct compiledRule {
+      int token;
+      int follow; //-1 when every occurrence counts
+      int followAgain;
+      indentRule rule;
+   };
+   
+   int tokenId(const QString &token);
+   
+   QVector<compiledRule> rules;
+   QHash<QString, int> words;
+   QVector<QPair<QString, int> > symbols; //longest first, so that ";;" is one token
+   int tokenCount = 0;
+};
+
 int* colorFromString(QString str);
-QString removeComments(QString);
-QString removeCommentsConservative(QString);
-QString removeUnusedLineBreaks(QString, bool isPersonalOutput);
-QStringList parseBlockCommand(QString cmd);
-QString indentCode(QString, QVector<indentKeyword>*, bool);
+QString stripComments(const QString &code, bool keepLineBreaks, QVector<int> *phraseEnds = NULL); //keepLineBreaks: for indentation analysis purposes
+QString indentCode(QString, const indentEngine*, bool);
+QString indentCodeConcurrently(const QString &code, const indentEngine *engine);
 QString removeIndent(QString);
 void fillIndentWords(QVector<indentKeyword>*);
 
+/* Drops the spaces before line breaks and collapses blank lines in the
+ * output of the toplevel, one chunk at a time and in place. What a chunk
+ * ends with is remembered, so that a blank line split over two chunks
+ * still collapses; a stream starts as if right after a line break. */
+class outputNormalizer
+{
+public:
+   outputNormalizer() : pendingSpaces(0), atLineStart(true) {}
+   void normalize(QByteArray *chunk);
+   void normalize(QString *chunk);
+   void reset() { pendingSpaces = 0; atLineStart = true; }
+   
+private:
+   template <typename Char> int normalizeRaw(Char *data, int length);
+   
+   int pendingSpaces; //trailing spaces held back: a line break may follow in the next chunk
+   bool atLineStart;
+};
+
+/* Splits the output of the toplevel into plain text and the frames that
+ * LemonCaml's printers wrap in --LemonCamlCommand-- or --LemonTree--
+ * markers, one chunk at a time. Between chunks, only an open frame, or
+ * what may be the start of a marker, is held back, so a frame split over
+ * several reads still comes out whole; an open frame is not scanned again
+ * from its start when more of it arrives. A frame still open when the
+ * next phrase is sent after the toplevel prompted is handed out as
+ * unterminated. */
+class outputFramer
+{
+public:
+   enum Kind {
+      Text,
+      Command,
+      Tree,
+      UnterminatedCommand, //never closed, or too long to be a frame; handed out as it is
+      UnterminatedTree
+   };
+   
+   struct piece {
+      Kind kind;
+      QString text; //without the markers
+   };
+   
+   enum {
+      MaxFrameLength = 1 << 24
+   };
+   
+   outputFramer() : frame(Text), scanned(0) {}
+   void feed(const QString &chunk, QVector<piece> *pieces);
+   //hands out what is held back, an open frame as unterminated, then starts over
+   void flush(QVector<piece> *pieces);
+   /* Flushes a frame that the last read left open right after the prompt:
+    * once the next phrase is sent, the toplevel will not close it. A prompt
+    * inside a frame ("\n#open" in a command) is only taken for one here,
+    * never while reading, where a read may stop right after its "#". */
+   void endAtPrompt(QVector<piece> *pieces);
+   void reset() { buffer.clear(); frame = Text; scanned = 0; }
+   
+private:
+   static void add(QVector<piece> *pieces, Kind kind, const QString &text);
+   
+   QString buffer; //the open frame, or text that may end with a partial marker
+   Kind frame; //Text out of frames
+   int scanned; //where the scan resumes in buffer
+};
+
+/* The arguments of a --LemonCamlCommand-- block, separated by spaces out
+ * of double quotes, with \n, \" and \\ escapes. They are unescaped in a
+ * single pass into one buffer, which the arguments point into. */
+class blockCommand
+{
+public:
+   enum Error {
+      NoError,
+      UnterminatedString,
+      DanglingEscape //a backslash ends the command
+   };
+   
+   blockCommand() : err(NoError), errPosition(-1) {}
+   bool parse(const QStringRef &cmd);
+   
+   int count() const { return arguments.count(); }
+   QStringRef argument(int i) const { return text.midRef(arguments.at(i).first, arguments.at(i).second); }
+   QStringList toStringList() const;
+   
+   Error error() const { return err; }
+   int errorPosition() const { return errPosition; } //in the command given to parse()
+   
+private:
+   QString text;
+   QVector<QPair<int, int> > arguments; //start and length in text
+   Error err;
+   int errPosition;
+};
+
+/* Compiles a pattern once and hands out shared copies afterwards; safe to
+ * call from any thread. */
+QRegularExpression cachedRegularExpression(const QString &pattern, QRegularExpression::PatternOptions options = QRegularExpression::NoPatternOption);
+
 
 
 
@@ -14,8 +14,127 @@
 // You should have received a copy of the GNU General Public License
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <algorithm>
+#include <QFileDialog>
+#include <QDirIterator>
+#include <QFile>
 #include "findreplace.h"
 
+static matchCount countMatches(QString text, QString pattern, bool regExp, Qt::CaseSensitivity cs, QSharedPointer<QAtomicInt> cancel)
+{
+   //runs on a worker thread, over a snapshot of the document
+   matchCount result;
+   result.cancelled = false;
+   QRegularExpression re;
+   if(regExp)
+      re = cachedRegularExpression(pattern, (cs == Qt::CaseSensitive) ? QRegularExpression::NoPatternOption : QRegularExpression::CaseInsensitiveOption);
+   
+   int line = 0;
+   int countedUpTo = 0; //line breaks before this position are in line
+   int index = 0;
+   int len = 0;
+   while(index < text.length())
+   {
+      if(cancel->loadAcquire() != 0)
+      {
+         result.cancelled = true;
+         return result;
+      }
+      
+      if(!regExp) {
+         index = text.indexOf(pattern, index, cs);
+         len = pattern.length();
+      } else {
+         QRegularExpressionMatch match = re.match(text, index);
+         index = match.hasMatch() ? match.capturedStart() : -1;
+         len = match.capturedLength();
+      }
+      if(index < 0)
+         break;
+      
+      if(len > 0) //like Replace All, empty matches do not count
+      {
+         for(; countedUpTo < index; countedUpTo++)
+         {
+            if(text.at(countedUpTo) == '\n')
+               line++;
+         }
+         result.starts << index;
+         result.lines << line;
+      }
+      index += (len == 0) ? 1 : len;
+   }
+   
+   result.lineCount = line + text.midRef(countedUpTo).count('\n') + 1;
+   return result;
+}
+
+QVector<fileHit> fileSearcher::operator()(const QString &path) const
+{
+   //runs on a worker thread, one file at a time
+   QVector<fileHit> hits;
+   QFile file(path);
+   if(!file.open(QIODevice::ReadOnly) || file.size() == 0)
+      return hits;
+   
+   uchar *mapped = file.map(0, file.size());
+   QByteArray contents = (mapped != NULL) ? QByteArray::fromRawData((const char*)mapped, file.size()) : file.readAll();
+   
+   //most files do not match at all: a case-sensitive literal is looked for in the raw bytes first
+   if(!regExp && cs == Qt::CaseSensitive && contents.indexOf(pattern.toUtf8()) < 0)
+      return hits;
+   
+   //files are UTF-8, as openFile reads them
+   QString text = QString::fromUtf8(contents.constData(), contents.size());
+   contents.clear();
+   if(mapped != NULL)
+      file.unmap(mapped);
+   
+   QRegularExpression re;
+   if(regExp)
+      re = cachedRegularExpression(pattern, (cs == Qt::CaseSensitive) ? QRegularExpression::NoPatternOption : QRegularExpression::CaseInsensitiveOption);
+   
+   int line = 0;
+   int lineStart = 0;
+   int index = 0;
+   while(index < text.length())
+   {
+      int len = 0;
+      if(!regExp) {
+         index = text.indexOf(pattern, index, cs);
+         len = pattern.length();
+      } else {
+         QRegularExpressionMatch match = re.match(text, index);
+         index = match.hasMatch() ? match.capturedStart() : -1;
+         len = match.capturedLength();
+      }
+      if(index < 0)
+         break;
+      if(len == 0)
+      {
+         index++;
+         continue;
+      }
+      
+      int lineEnd;
+      while((lineEnd = text.indexOf('\n', lineStart)) >= 0 && lineEnd < index)
+      {
+         lineStart = lineEnd + 1;
+         line++;
+      }
+      if(lineEnd < 0)
+         lineEnd = text.length();
+      
+      fileHit hit;
+      hit.path = path;
+      hit.line = line;
+      hit.text = text.mid(lineStart, lineEnd - lineStart).trimmed();
+      hits << hit;
+      index = lineEnd + 1; //one hit per line is enough
+   }
+   return hits;
+}
+
 /* The following stuff is very complicated, may seem obfuscated.
  * I don't use regexps everywhere for the simple reason they are
  * more expensive than pure string matchings for simple searches */
@@ -26,6 +145,7 @@ findReplace::findReplace(QTextEdit *d, highlighter *h) :
 {
    this->doc = d;
    this->hlt = h;
+   this->search = new searchIndex(d->document(), this);
    this->findText = new QLineEdit(this);
    this->replaceText = new QLineEdit(this);
    QLabel *findLabel = new QLabel(tr("Find:"), this);
@@ -48,7 +168,30 @@ findReplace::findReplace(QTextEdit *d, highlighter *h) :
    this->hilitAll->setChecked(isHighlighting);
    this->replace = new QPushButton(tr("Replace next"));
    this->replaceAll = new QPushButton(tr("Replace All"));
+   this->findInFiles = new QPushButton(tr("Find in files..."));
    this->statusLabel = new QLabel("", this);
+   this->countLabel = new QLabel("", this);
+   
+   this->fileResults = new QListWidget(this);
+   this->fileResults->setVisible(false);
+   this->fileSearch = new QFutureWatcher< QVector<fileHit> >(this);
+   connect(fileSearch,SIGNAL(resultsReadyAt(int,int)),this,SLOT(fileResultsReady(int,int)));
+   connect(fileSearch,SIGNAL(finished()),this,SLOT(fileSearchFinished()));
+   connect(fileResults,SIGNAL(itemActivated(QListWidgetItem*)),this,SLOT(fileResultActivated(QListWidgetItem*)));
+   connect(findInFiles,SIGNAL(clicked()),this,SLOT(doFindInFiles()));
+   
+   this->countValid = false;
+   this->counter = new QFutureWatcher<matchCount>(this);
+   this->countTimer = new QTimer(this);
+   this->countTimer->setSingleShot(true);
+   this->countTimer->setInterval(CountDelayMs);
+   connect(countTimer,SIGNAL(timeout()),this,SLOT(startCount()));
+   
+   this->findTimer = new QTimer(this);
+   this->findTimer->setSingleShot(true);
+   this->findTimer->setInterval(FindDelayMs);
+   connect(findTimer,SIGNAL(timeout()),this,SLOT(findEditedPattern()));
+   connect(counter,SIGNAL(finished()),this,SLOT(countFinished()));
    
    QPushButton *closeButton = new QPushButton(tr("Close"), this);
    closeButton->setIcon(QIcon(":/stopcaml.png"));
@@ -64,6 +207,7 @@ findReplace::findReplace(QTextEdit *d, highlighter *h) :
    topLayout->addWidget(findText);
    topLayout->addWidget(find);
    topLayout->addWidget(hilitAll);
+   topLayout->addWidget(findInFiles);
 
    
    wrapperReplaceWidget = new QWidget();
@@ -79,6 +223,7 @@ findReplace::findReplace(QTextEdit *d, highlighter *h) :
    optionsLayout->addWidget(showHideReplace);
    optionsLayout->addWidget(closeButton);
    optionsLayout->addWidget(statusLabel);
+   optionsLayout->addWidget(countLabel);
    optionsLayout->addStretch(1);
    
    wrapperReplaceWidget->setVisible(false);
@@ -88,9 +233,10 @@ findReplace::findReplace(QTextEdit *d, highlighter *h) :
    layout->addLayout(topLayout);
    layout->addWidget(wrapperReplaceWidget);
    layout->addLayout(optionsLayout);
+   layout->addWidget(fileResults);
    
    connect(showHideReplace,SIGNAL(clicked(bool)),this,SLOT(triggerReplace(bool)));
-   connect(findText,SIGNAL(textChanged(QString)),this, SLOT(doFind(QString)));
+   connect(findText,SIGNAL(textChanged(QString)),this, SLOT(patternEdited()));
    connect(find,SIGNAL(clicked()),this,SLOT(findNextOccurence()));
    connect(replace,SIGNAL(clicked()),this,SLOT(doReplace()));
    connect(replaceAll,SIGNAL(clicked()),this,SLOT(doReplaceAll()));
@@ -100,6 +246,10 @@ findReplace::findReplace(QTextEdit *d, highlighter *h) :
    connect(findText,SIGNAL(returnPressed()),this,SLOT(findNextOccurence()));
    connect(replaceText,SIGNAL(returnPressed()),this,SLOT(doReplace()));
    
+   //search results are drawn over the visible part of the document only
+   connect(doc->verticalScrollBar(),SIGNAL(valueChanged(int)),this,SLOT(highlightAllResults()));
+   connect(doc->document(),SIGNAL(contentsChange(int,int,int)),this,SLOT(documentChanged(int,int,int)));
+   
    this->setLayout(layout);
 }
 
@@ -118,48 +268,63 @@ void findReplace::triggerReplace(bool show)
    }
 }
 
+void findReplace::setIndexed(bool indexed)
+{
+   search->setIndexed(indexed);
+}
+
 void findReplace::takeFocus()
 {
    findText->setFocus(Qt::PopupFocusReason);
 }
 
+void findReplace::patternEdited()
+{
+   //the count of the previous pattern is useless already, the search waits for the next keystroke
+   cancelCount();
+   findTimer->start();
+}
+
+void findReplace::findEditedPattern()
+{
+   doFind(findText->text());
+}
+
 void findReplace::doFind(QString txt)
 {   
-   highlightAllResults(); //do it before the check so that the rule may be cleared
+   findTimer->stop();
    QTextCursor cursor = doc->textCursor();
    if(txt == "") {
+      highlightAllResults(); //clears the results
+      scheduleCount();
       cursor.clearSelection();
       doc->setTextCursor(cursor);
       return;
    }
-   QString contents = doc->toPlainText();
-
-   
    Qt::CaseSensitivity sensitivity = (searchCaseSensitive)?Qt::CaseSensitive:Qt::CaseInsensitive;
    
+   if(searchRegExp) {
+      //a pattern being typed is often invalid for a while, there is nothing to search then
+      QRegularExpression re = cachedRegularExpression(txt, searchCaseSensitive ? QRegularExpression::NoPatternOption : QRegularExpression::CaseInsensitiveOption);
+      if(!re.isValid()) {
+         clearHighlightedResults();
+         cancelCount();
+         countLabel->setText("");
+         statusLabel->setText(tr("Invalid regular expression: %1").arg(re.errorString()));
+         return;
+      }
+   }
+   
+   highlightAllResults();
+   scheduleCount();
+   
    //find the closest match from the cursor
    
-   int prevMatch = 0;
-   int nextMatch = 0;
    int pos = cursor.position();
    int len = 0;
-   if(!searchRegExp) {
-      prevMatch = contents.lastIndexOf(txt, pos, sensitivity);
-      nextMatch = contents.indexOf(txt, pos-1, sensitivity);
-      len = txt.length();
-   } else {
-      QRegExp re(txt, sensitivity);
-      prevMatch = re.lastIndexIn(contents, pos);
-      nextMatch = re.indexIn(contents, pos);
-      len = re.matchedLength();
-   }
-   int nextPos = 0;
+   int nextPos = search->findClosest(txt, searchRegExp, sensitivity, pos, &len);
    
-   if((prevMatch == -1 && nextMatch >= 0) || ( (prevMatch >= 0 && nextMatch >= 0) && (pos - prevMatch >= nextMatch - pos)))
-      nextPos = nextMatch;
-   else if ((prevMatch >= 0 && nextMatch == -1) || ( (prevMatch >= 0 && nextMatch >= 0) && (pos - prevMatch < nextMatch - pos)))
-      nextPos = prevMatch;
-   else {
+   if(nextPos < 0) {
       status(NotFound);
       cursor.setPosition(pos);
       doc->setTextCursor(cursor);
@@ -174,43 +339,34 @@ void findReplace::doFind(QString txt)
    
    cursor.setPosition(nextPos + len, QTextCursor::KeepAnchor);
    doc->setTextCursor(cursor);
-   
+   showCount();
 }
 
 void findReplace::findNextOccurence()
 {
-   QString contents = doc->toPlainText();
+   if(findTimer->isActive()) { //Enter right after typing: look for the pattern first
+      doFind(findText->text());
+      return;
+   }
+   
    QTextCursor cursor = doc->textCursor();
    
    Qt::CaseSensitivity sensitivity = (searchCaseSensitive)?Qt::CaseSensitive:Qt::CaseInsensitive;
 
    QString txt = findText->text();
-   QRegExp re(txt, sensitivity);
    
    if(txt == "") return;
    //find the closest match from the cursor
-   int nextMatch = 0;
    int pos = cursor.position();
    int len = 0;
-   if(!searchRegExp) {
-      nextMatch = contents.indexOf(txt, pos + txt.length(), sensitivity);
-      len = txt.length();
-   } else {
-      nextMatch = re.indexIn(contents, pos);
-      len = re.matchedLength();
-   }
+   int nextMatch = search->find(txt, searchRegExp, sensitivity, searchRegExp ? pos : pos + txt.length(), false, &len);
    
    if (nextMatch >= 0) {
       status(OK);
       cursor.setPosition(nextMatch);
       cursor.setPosition(nextMatch + len, QTextCursor::KeepAnchor);
    } else { //is there any match at the beginning of the document?
-      if(!searchRegExp) {
-         nextMatch = contents.indexOf(txt, 0, sensitivity);
-      } else {
-         nextMatch = re.indexIn(contents, 0);
-         len = re.matchedLength();
-      }
+      nextMatch = search->find(txt, searchRegExp, sensitivity, 0, false, &len);
       if (nextMatch >= 0) {
          status(ReachEndDoc);
          cursor.setPosition(nextMatch);
@@ -219,6 +375,7 @@ void findReplace::findNextOccurence()
    }
    
    doc->setTextCursor(cursor);
+   showCount();
 }
 
 void findReplace::setCaseSensitive(bool is)
@@ -243,38 +400,171 @@ void findReplace::triggerHighlightResults(bool doIt)
    else
    {
       isHighlighting = false;
-      hlt->undoSearchRule(); 
+      clearHighlightedResults();
    }
 }
 
 void findReplace::highlightAllResults()
 {
-   if(isHighlighting)
+   if(!isHighlighting || !isVisible())
+      return;
+   
+   QString txt = findText->text();
+   if(txt == "") {
+      clearHighlightedResults();
+      return;
+   }
+   Qt::CaseSensitivity sensitivity = (searchCaseSensitive)?Qt::CaseSensitive:Qt::CaseInsensitive;
+   QRegularExpression re;
+   if(searchRegExp)
+      re = cachedRegularExpression(txt, searchCaseSensitive ? QRegularExpression::NoPatternOption : QRegularExpression::CaseInsensitiveOption);
+   
+   //only what is on screen, plus a few lines so that small scrolls look right
+   int first = doc->cursorForPosition(QPoint(0, 0)).blockNumber() - HighlightMargin;
+   int last = doc->cursorForPosition(QPoint(0, doc->viewport()->height())).blockNumber() + HighlightMargin;
+   QTextBlock block = doc->document()->findBlockByNumber(qMax(0, first));
+   
+   QTextEdit::ExtraSelection sel;
+   sel.format = hlt->formatFor(highlighter::SearchResult);
+   QList<QTextEdit::ExtraSelection> selections;
+   
+   for(int i = qMax(0, first); i <= last && block.isValid(); i++)
    {
-      if(findText->text() == "") {
-         hlt->undoSearchRule();
-         return;
-      }
-      Qt::CaseSensitivity sensitivity = (searchCaseSensitive)?Qt::CaseSensitive:Qt::CaseInsensitive;
-      //do some stuff with the Highlighter
-      QString expr = "";
-      if(searchRegExp)
-         hlt->addSearchRule(QRegExp(findText->text(), sensitivity));
-      else {
-         hlt->addSearchRule(QRegExp(findText->text(), sensitivity, QRegExp::FixedString));
+      QString text = block.text();
+      int index = 0;
+      int len = txt.length();
+      while(index >= 0 && index < text.length())
+      {
+         if(!searchRegExp) {
+            index = text.indexOf(txt, index, sensitivity);
+         } else {
+            QRegularExpressionMatch match = re.match(text, index);
+            index = match.hasMatch() ? match.capturedStart() : -1;
+            len = match.capturedLength();
+         }
+         if(index >= 0)
+         {
+            sel.cursor = QTextCursor(block);
+            sel.cursor.setPosition(block.position() + index);
+            sel.cursor.setPosition(block.position() + index + len, QTextCursor::KeepAnchor);
+            selections << sel;
+            index += (len == 0) ? 1 : len; //a regexp may match the empty string
+         }
       }
+      block = block.next();
    }
    
+   doc->setExtraSelections(selections);
+}
+
+void findReplace::clearHighlightedResults()
+{
+   doc->setExtraSelections(QList<QTextEdit::ExtraSelection>());
+}
+
+void findReplace::documentChanged(int from, int charsRemoved, int charsAdded)
+{
+   Q_UNUSED(from);
+   if(charsRemoved != 0 || charsAdded != 0) //not a mere format change
+   {
+      highlightAllResults();
+      scheduleCount();
+   }
+}
+
+void findReplace::scheduleCount()
+{
+   //whatever is being counted is out of date
+   cancelCount();
+   countValid = false;
+   countLabel->setText("");
+   if(findText->text() == "")
+   {
+      countedMatches.clear();
+      if(markerScrollBar *markers = qobject_cast<markerScrollBar*>(doc->verticalScrollBar()))
+         markers->clearMarkers();
+      return;
+   }
+   if(isVisible())
+      countTimer->start();
+}
+
+void findReplace::cancelCount()
+{
+   countTimer->stop();
+   if(counterCancel)
+      counterCancel->storeRelease(1);
+}
+
+void findReplace::startCount()
+{
+   QString txt = findText->text();
+   if(txt == "" || !isVisible())
+      return;
+   
+   Qt::CaseSensitivity sensitivity = (searchCaseSensitive)?Qt::CaseSensitive:Qt::CaseInsensitive;
+   counterCancel = QSharedPointer<QAtomicInt>(new QAtomicInt(0));
+   counter->setFuture(QtConcurrent::run(countMatches, doc->toPlainText(), txt, searchRegExp, sensitivity, counterCancel));
+}
+
+void findReplace::countFinished()
+{
+   matchCount result = counter->result();
+   if(result.cancelled)
+      return;
+   
+   countedMatches = result.starts;
+   countValid = true;
+   
+   if(markerScrollBar *markers = qobject_cast<markerScrollBar*>(doc->verticalScrollBar()))
+   {
+      QVector<qreal> ticks;
+      ticks.reserve(result.lines.count());
+      for(int i = 0; i < result.lines.count(); i++)
+         ticks << (qreal)result.lines.at(i) / result.lineCount;
+      markers->setMarkers(ticks);
+   }
+   showCount();
+}
+
+void findReplace::showCount()
+{
+   if(!countValid)
+      return;
+   
+   //"n of N" when the selection is one of the matches
+   int selected = doc->textCursor().selectionStart();
+   QVector<int>::const_iterator it = std::lower_bound(countedMatches.constBegin(), countedMatches.constEnd(), selected);
+   if(doc->textCursor().hasSelection() && it != countedMatches.constEnd() && *it == selected)
+      countLabel->setText(tr("%1 of %2").arg(it - countedMatches.constBegin() + 1).arg(countedMatches.count()));
+   else
+      countLabel->setText(tr("%n match(es)", "", countedMatches.count()));
+}
+
+void findReplace::showEvent(QShowEvent *event)
+{
+   QGroupBox::showEvent(event);
+   highlightAllResults();
+   scheduleCount();
+}
+
+void findReplace::hideEvent(QHideEvent *event)
+{
+   QGroupBox::hideEvent(event);
+   clearHighlightedResults();
+   cancelCount();
+   countValid = false;
+   countLabel->setText("");
+   if(markerScrollBar *markers = qobject_cast<markerScrollBar*>(doc->verticalScrollBar()))
+      markers->clearMarkers();
 }
 
 void findReplace::doReplace()
 {
-   QString contents = doc->toPlainText();
    QTextCursor cursor = doc->textCursor();
    
    Qt::CaseSensitivity sensitivity = (searchCaseSensitive)?Qt::CaseSensitive:Qt::CaseInsensitive;
    QString txt = findText->text();
-   QRegExp re(txt, sensitivity);
    if(txt == "") return;
    //find the closest match from the cursor
    int nextMatch = 0;
@@ -286,25 +576,14 @@ void findReplace::doReplace()
    else
       pos = cursor.selectionStart();
    
-   if(!searchRegExp) {
-      nextMatch = contents.indexOf(txt, pos-1, sensitivity);
-      len = txt.length();
-   } else {
-      nextMatch = re.indexIn(contents, pos-1);
-      len = re.matchedLength();
-   }
+   nextMatch = search->find(txt, searchRegExp, sensitivity, pos-1, false, &len);
    
    if (nextMatch >= 0) {
       status(OK);
       cursor.setPosition(nextMatch);
       cursor.setPosition(nextMatch + len, QTextCursor::KeepAnchor);
    } else { //is there any match at the beginning of the document?
-      if(!searchRegExp) {
-         nextMatch = contents.indexOf(txt, 0, sensitivity);
-      } else {
-         nextMatch = re.indexIn(contents, 0);
-         len = re.matchedLength();
-      }
+      nextMatch = search->find(txt, searchRegExp, sensitivity, 0, false, &len);
       if (nextMatch >= 0) {
          status(ReachEndDoc);
          cursor.setPosition(nextMatch);
@@ -328,36 +607,120 @@ void findReplace::doReplace()
 
 void findReplace::doReplaceAll()
 {
-   //index them all
+   //index them all on a single snapshot...
    int index = 0;
    Qt::CaseSensitivity sensitivity = (searchCaseSensitive)?Qt::CaseSensitive:Qt::CaseInsensitive;
    QString txt = findText->text();
-   QTextCursor cursor = doc->textCursor();
-   QString document = doc->toPlainText();
-   QRegExp re(txt, sensitivity);
    if(txt == "") return;
+   QString document = doc->toPlainText();
+   QRegularExpression re;
+   if(searchRegExp)
+      re = cachedRegularExpression(txt, searchCaseSensitive ? QRegularExpression::NoPatternOption : QRegularExpression::CaseInsensitiveOption);
    
+   QVector<int> matchStarts;
+   QVector<int> matchLengths;
    int len = 0; //with regexp, we can't predict the length of the match
-   do
+   while(index >= 0 && index < document.length())
    {
       if(!searchRegExp) {
          index = document.indexOf(txt, index , sensitivity);
          len = txt.length();
       } else {
-         index = re.indexIn(document, index);
-         len = re.matchedLength();
+         QRegularExpressionMatch match = re.match(document, index);
+         index = match.hasMatch() ? match.capturedStart() : -1;
+         len = match.capturedLength();
       }
       if(index >= 0)
       {
-         cursor.setPosition(index);
-         cursor.setPosition(index + len, QTextCursor::KeepAnchor);
-         doc->setTextCursor(cursor);
-         doc->insertPlainText(replaceText->text());
-         document = doc->toPlainText();
-         index += replaceText->text().length();
+         if(len > 0) //a regexp may match the empty string, there is nothing to replace then
+         {
+            matchStarts << index;
+            matchLengths << len;
+         }
+         index += (len == 0) ? 1 : len;
       }
-   } while(index >= 0);
+   }
+   
+   if(matchStarts.isEmpty())
+   {
+      status(NotFound);
+      return;
+   }
+   
+   //...then replace them from the end, so that the positions found stay valid,
+   //in one edit block: a single undo step and a single contentsChange
+   QString replacement = replaceText->text();
+   QTextCursor cursor(doc->document());
+   cursor.beginEditBlock();
+   for(int i = matchStarts.count() - 1; i >= 0; i--)
+   {
+      cursor.setPosition(matchStarts.at(i));
+      cursor.setPosition(matchStarts.at(i) + matchLengths.at(i), QTextCursor::KeepAnchor);
+      cursor.insertText(replacement);
+   }
+   cursor.endEditBlock();
+   
+   statusLabel->setText(tr("%n occurrence(s) replaced", "", matchStarts.count()));
+}
+
+void findReplace::doFindInFiles()
+{
+   QString txt = findText->text();
+   if(txt == "") return;
    
+   QString dir = QFileDialog::getExistingDirectory(this, tr("Find in files"), fileSearchRoot);
+   if(dir == "") return;
+   fileSearchRoot = dir;
+   
+   //a search still running is superseded
+   fileSearch->cancel();
+   fileSearch->waitForFinished();
+   fileResults->clear();
+   fileResults->setVisible(true);
+   
+   QStringList files;
+   QDirIterator it(dir, QStringList() << "*.ml" << "*.mli", QDir::Files, QDirIterator::Subdirectories);
+   while(it.hasNext())
+      files << it.next();
+   
+   fileSearcher searcher;
+   searcher.pattern = txt;
+   searcher.regExp = searchRegExp;
+   searcher.cs = (searchCaseSensitive)?Qt::CaseSensitive:Qt::CaseInsensitive;
+   
+   statusLabel->setText(tr("Searching %n file(s)...", "", files.count()));
+   fileSearch->setFuture(QtConcurrent::mapped(files, searcher));
+}
+
+void findReplace::fileResultsReady(int begin, int end)
+{
+   //results come in as files are searched, in no particular order
+   QDir root(fileSearchRoot);
+   for(int i = begin; i < end; i++)
+   {
+      QVector<fileHit> hits = fileSearch->resultAt(i);
+      for(int j = 0; j < hits.count(); j++)
+      {
+         QListWidgetItem *item = new QListWidgetItem(root.relativeFilePath(hits.at(j).path) + ":" + QString::number(hits.at(j).line + 1) + ": " + hits.at(j).text, fileResults);
+         item->setData(Qt::UserRole, hits.at(j).path);
+         item->setData(Qt::UserRole + 1, hits.at(j).line);
+      }
+   }
+}
+
+void findReplace::fileSearchFinished()
+{
+   if(fileSearch->isCanceled())
+      return;
+   if(fileResults->count() == 0)
+      status(NotFound);
+   else
+      statusLabel->setText(tr("%n result(s) in files", "", fileResults->count()));
+}
+
+void findReplace::fileResultActivated(QListWidgetItem *item)
+{
+   emit openFileRequest(item->data(Qt::UserRole).toString(), item->data(Qt::UserRole + 1).toInt());
 }
 
 void findReplace::hide() 
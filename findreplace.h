@@ -24,15 +24,49 @@
 #include <QGroupBox>
 #include <QTextDocument>
 #include <QDebug>
-#include <QRegExp>
+#include <QRegularExpression>
+#include <QScrollBar>
+#include <QTimer>
+#include <QAtomicInt>
+#include <QSharedPointer>
+#include <QFutureWatcher>
+#include <QtConcurrentRun>
+#include <QtConcurrentMap>
+#include <QListWidget>
 #include "highlighter.h"
 #include "inputzone.h"
+#include "searchindex.h"
 
 #ifndef FINDREPLACE_H
 #define FINDREPLACE_H
 
 
 
+//every match of a search, counted on a worker thread
+struct matchCount {
+   bool cancelled;
+   QVector<int> starts;
+   QVector<int> lines;
+   int lineCount;
+};
+
+struct fileHit {
+   QString path;
+   int line; //from 0
+   QString text;
+};
+
+//looks for a pattern in one file, run over many files by QtConcurrent::mapped
+struct fileSearcher {
+   typedef QVector<fileHit> result_type;
+   
+   QString pattern;
+   bool regExp;
+   Qt::CaseSensitivity cs;
+   
+   QVector<fileHit> operator()(const QString &path) const;
+};
+
 class findReplace : public QGroupBox
 {
    Q_OBJECT
@@ -40,6 +74,9 @@ public:
    findReplace(QTextEdit*, highlighter*);
    void takeFocus();
    
+   //keeps a trigram index of the document, so that finding reads only the blocks that may match
+   void setIndexed(bool indexed);
+   
    enum searchstat {
       OK,
       NotFound,
@@ -47,6 +84,12 @@ public:
    };
    
 private:
+   enum {
+      HighlightMargin = 50, //blocks highlighted above and below the visible ones
+      CountDelayMs = 250, //matches are counted once the typing stops
+      FindDelayMs = 30 //keystrokes closer than this make a single search
+   };
+   
    QVBoxLayout *layout;
    QLineEdit *findText;
    QLineEdit *replaceText;
@@ -60,25 +103,48 @@ private:
    QPushButton *hilitAll;
    QPushButton *replace;
    QPushButton *replaceAll;
+   QPushButton *findInFiles;
+   QListWidget *fileResults;
+   QFutureWatcher< QVector<fileHit> > *fileSearch;
+   QString fileSearchRoot;
    QTextEdit *doc;
    QLabel *statusLabel;
+   QLabel *countLabel;
    highlighter *hlt;
+   searchIndex *search; //finds matches one block at a time
    
    bool searchCaseSensitive;
    bool searchRegExp;
    bool isHighlighting;
 
+   QFutureWatcher<matchCount> *counter;
+   QSharedPointer<QAtomicInt> counterCancel;
+   QTimer *countTimer;
+   QTimer *findTimer;
+   bool countValid;
+   QVector<int> countedMatches; //where each match starts, when countValid
+
    void status(searchstat us);
-   void highlightAllResults();
+   void clearHighlightedResults();
+   void scheduleCount();
+   void cancelCount();
+   void showCount();
+   
+protected:
+   void showEvent(QShowEvent *event);
+   void hideEvent(QHideEvent *event);
    
 signals:
    void hideRequest(bool);
+   void openFileRequest(QString file, int line);
    
 public slots:
    void triggerReplace(bool show);
    
 private slots:
    void doFind(QString);
+   void patternEdited();
+   void findEditedPattern();
    void findNextOccurence();
    void setCaseSensitive(bool);
    void setRegExp(bool);
@@ -86,6 +152,14 @@ private slots:
    void doReplace();
    void doReplaceAll();
    void hide();
+   void highlightAllResults();
+   void documentChanged(int from, int charsRemoved, int charsAdded);
+   void startCount();
+   void countFinished();
+   void doFindInFiles();
+   void fileResultsReady(int begin, int end);
+   void fileSearchFinished();
+   void fileResultActivated(QListWidgetItem *item);
 };
 
 
@@ -7,7 +7,7 @@ echo "Building the Caml Light toplevel"
 if [ $? == 0 ]; then
    echo "The Caml Light toplevel has been successfully compiled."
    echo "Now compiling LemonCaml."
-   qmake
+   qmake LemonCaml.pro
    make >> ./log.txt 2>&1
    if [ $? == 0 ]; then
       echo "LemonCaml has been successfully built."
@@ -19,13 +19,11 @@ if [ $? == 0 ]; then
       fi
       sudo mkdir $DESTDIR
       sudo cp -rf ./caml $DESTDIR
-      sudo cp ./keywords $DESTDIR
       sudo cp ./lemoncaml_*.qm $DESTDIR
       sudo cp -rf ./gentree $DESTDIR
       sudo mkdir /etc/xdg/Cocodidou
       echo "[%General]" > ./LemonCaml.conf
       echo "camlPath=$DESTDIR/caml/CamlLightToplevel" >> ./LemonCaml.conf
-      echo "keywordspath=$DESTDIR/keywords" >> ./LemonCaml.conf
       echo "camlArgs= -stdlib \"$DESTDIR/caml/lib\"" >> ./LemonCaml.conf
       echo "treeModelsPath=$DESTDIR/gentree" >> ./LemonCaml.conf
       echo "setupPath=$DESTDIR/" >> ./LemonCaml.conf
@@ -0,0 +1,160 @@
+# genkeywords.awk - Builds the built-in keyword table out of the "keywords" file
+# This file is part of LemonCaml - Copyright (C) 2012-2014 Corentin FERRY
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Usage: awk -f genkeywords.awk keywords > keywords_table.h
+#
+# keywords_table.h is checked in so that building needs no awk; run the
+# line above again whenever the keywords file changes.
+#
+# Identifier-like keywords are put in a collision-free hash table: every
+# keyword first falls into a bucket, then each bucket gets a multiplier
+# that sends all of its keywords to free slots. The hash functions must
+# stay in sync with lookupBuiltinKeyword() in camllexer.cpp.
+
+BEGIN {
+   FS = ";"
+   for (i = 32; i < 127; i++)
+      ord[sprintf("%c", i)] = i
+   bits = 9
+   nkw = 0
+   nop = 0
+}
+
+/^#/ { next }
+$0 == "" { exit } # the runtime loader also stops at the first empty line
+
+NF == 2 && $1 != "" && $2 != "" {
+   if ($1 ~ /^[A-Za-z0-9_]+$/) {
+      if (!($1 in kwConstruct))
+         kwName[nkw++] = $1
+      kwConstruct[$1] = $2
+   } else {
+      if (!($1 in opConstruct))
+         opName[nop++] = $1
+      opConstruct[$1] = $2
+   }
+}
+
+function fold(s,    b, i) {
+   b = 0
+   for (i = 1; i <= length(s); i++)
+      b = (b * 131 + ord[substr(s, i, 1)]) % 16777216
+   return b
+}
+
+function mix(b, k) {
+   return int(((b * k) % 16777216) / (2 ^ (24 - bits)))
+}
+
+function cstring(s) {
+   gsub(/\\/, "\\\\", s)
+   gsub(/"/, "\\\"", s)
+   return "\"" s "\""
+}
+
+END {
+   size = 2 ^ bits
+   while (size < 2 * nkw) {
+      bits++
+      size = 2 ^ bits
+   }
+   buckets = int(nkw / 4) + 1
+
+   for (i = 0; i < nkw; i++) {
+      b = fold(kwName[i]) % buckets
+      bucketSize[b]++
+      bucketKw[b, bucketSize[b]] = kwName[i]
+   }
+
+   # largest buckets first, they are the hardest to place
+   for (done = 0; done < buckets; done++) {
+      best = -1
+      for (b = 0; b < buckets; b++)
+         if (!(b in placed) && (best < 0 || bucketSize[b] > bucketSize[best]))
+            best = b
+      placed[best] = 1
+      mult[best] = 1
+      if (bucketSize[best] == 0)
+         continue
+
+      for (k = 1; k < 16777216; k += 2) {
+         ok = 1
+         delete tried
+         for (j = 1; j <= bucketSize[best] && ok; j++) {
+            slot = mix(fold(bucketKw[best, j]), k)
+            if ((slot in slotKw) || (slot in tried))
+               ok = 0
+            tried[slot] = 1
+         }
+         if (ok)
+            break
+      }
+      if (!ok) {
+         print "genkeywords.awk: unable to build a collision-free table" > "/dev/stderr"
+         exit 1
+      }
+      mult[best] = k
+      for (j = 1; j <= bucketSize[best]; j++)
+         slotKw[mix(fold(bucketKw[best, j]), k)] = bucketKw[best, j]
+   }
+
+   print "// keywords_table.h - Built-in keywords, generated from the \"keywords\" file"
+   print "// by genkeywords.awk. Do not edit: edit \"keywords\" instead."
+   print ""
+   print "#ifndef KEYWORDS_TABLE_H"
+   print "#define KEYWORDS_TABLE_H"
+   print ""
+   print "struct builtinKeyword {"
+   print "   const char *word;"
+   print "   int length;"
+   print "   int construct;"
+   print "};"
+   print ""
+   print "static constexpr int builtinKeywordBits = " bits ";"
+   print "static constexpr int builtinKeywordBuckets = " buckets ";"
+   print ""
+   print "static constexpr unsigned int builtinKeywordMultipliers[builtinKeywordBuckets] = {"
+   line = "  "
+   for (b = 0; b < buckets; b++) {
+      line = line " " mult[b] ","
+      if (length(line) > 70) {
+         print line
+         line = "  "
+      }
+   }
+   if (line != "  ")
+      print line
+   print "};"
+   print ""
+   print "static constexpr builtinKeyword builtinKeywords[1 << builtinKeywordBits] = {"
+   for (s = 0; s < size; s++) {
+      if (s in slotKw)
+         print "   { " cstring(slotKw[s]) ", " length(slotKw[s]) ", " kwConstruct[slotKw[s]] " },"
+      else
+         print "   { 0, 0, -1 },"
+   }
+   print "};"
+   print ""
+   print "static constexpr int builtinOperatorCount = " nop ";"
+   print ""
+   print "static constexpr builtinKeyword builtinOperators[builtinOperatorCount + 1] = {"
+   for (i = 0; i < nop; i++)
+      print "   { " cstring(opName[i]) ", " length(opName[i]) ", " opConstruct[opName[i]] " },"
+   print "   { 0, 0, -1 }"
+   print "};"
+   print ""
+   print "#endif"
+}
@@ -16,31 +16,389 @@
 
 #include "highlighter.h"
 
+static_assert((int)camlLexer::Comment == (int)highlighter::Comment && (int)camlLexer::Preprocessor == (int)highlighter::Preprocessor
+              && (int)camlLexer::String == (int)highlighter::String && (int)camlLexer::Char == (int)highlighter::Char
+              && (int)camlLexer::DefinedFunction == (int)highlighter::UserFunction && (int)camlLexer::DefinedType == (int)highlighter::UserType
+              && (int)camlLexer::DefinedConstructor == (int)highlighter::UserConstructor && (int)camlLexer::Identifier > (int)highlighter::LastConstruct,
+              "camlLexer token classes must be numbered like highlighter::Construct");
+
+void definitionIndex::add(const QString &name, int construct)
+{
+   counts[construct - highlighter::UserFunction][name]++;
+   resolve(name);
+}
+
+void definitionIndex::remove(const QString &name, int construct)
+{
+   QHash<QString, int> &count = counts[construct - highlighter::UserFunction];
+   QHash<QString, int>::iterator it = count.find(name);
+   if(it == count.end())
+      return;
+   if(--it.value() == 0)
+      count.erase(it);
+   resolve(name);
+}
+
+void definitionIndex::resolve(const QString &name)
+{
+   //constructors and values share a namespace, and hide types when they have the same name
+   int construct = -1;
+   if(counts[highlighter::UserConstructor - highlighter::UserFunction].contains(name))
+      construct = highlighter::UserConstructor;
+   else if(counts[0].contains(name))
+      construct = highlighter::UserFunction;
+   else if(counts[highlighter::UserType - highlighter::UserFunction].contains(name))
+      construct = highlighter::UserType;
+   
+   if(construct == resolved.value(name, -1))
+      return;
+   if(construct < 0)
+      resolved.remove(name);
+   else
+      resolved.insert(name, construct);
+   changed.insert(name);
+}
+
+QSet<QString> definitionIndex::takeChanges()
+{
+   QSet<QString> names;
+   names.swap(changed);
+   return names;
+}
+
+void definitionIndex::setUses(highlightData *data, const QSet<QString> &names)
+{
+   if(names == data->uses)
+      return;
+   for(QSet<QString>::const_iterator it = data->uses.constBegin(); it != data->uses.constEnd(); ++it)
+   {
+      QHash<QString, QSet<highlightData*> >::iterator user = users.find(*it);
+      if(user == users.end())
+         continue;
+      user.value().remove(data);
+      if(user.value().isEmpty())
+         users.erase(user);
+   }
+   for(QSet<QString>::const_iterator it = names.constBegin(); it != names.constEnd(); ++it)
+      users[*it].insert(data);
+   data->uses = names;
+}
+
+static QVector<tokenizedBlock> tokenizeBlocks(const camlLexer *lexer, const tokenizerJob &job)
+{
+   //runs on a worker thread: only touches the snapshot and the (read-only) lexer
+   QVector<tokenizedBlock> result(job.texts.count());
+   int state = job.entryState;
+   for(int i = 0; i < job.texts.count(); i++)
+   {
+      tokenizedBlock &blk = result[i];
+      blk.revision = job.revisions.at(i);
+      blk.entryState = state;
+      blk.length = job.texts.at(i).length();
+      state = lexer->lex(job.texts.at(i), state, &blk.tokens);
+      blk.exitState = state;
+   }
+   return result;
+}
+
 highlighter::highlighter(QTextDocument *document, QStringList *kw, QSettings *set)
 : QSyntaxHighlighter(document)
 {
   this->settings = set;
+  
+  //the lazy mode is looked at by highlightBlock, set it up before the first rehighlight
+  this->editor = NULL;
+  this->lazyThreshold = settings->value("Input/lazyHighlightThreshold", 5000).toInt();
+  this->pendingFrom = 0;
+  this->firstVisible = 0;
+  this->lastVisible = 0;
+  this->visibleRangeDirty = false;
+  this->forceFormat = false;
+  this->idleTimer = new QTimer(this);
+  this->idleTimer->setInterval(0);
+  connect(idleTimer, SIGNAL(timeout()), this, SLOT(highlightPendingChunk()));
+  
+  this->tokenizingFrom = 0;
+  this->staleFrom = -1;
+  this->tokenizer = new QFutureWatcher< QVector<tokenizedBlock> >(this);
+  connect(tokenizer, SIGNAL(finished()), this, SLOT(tokenizerFinished()));
+  //connected after QSyntaxHighlighter's own slot: the edit has been highlighted when ours runs
+  connect(document, SIGNAL(contentsChange(int,int,int)), this, SLOT(documentChanged(int,int,int)));
+  
+  this->definitions = QSharedPointer<definitionIndex>(new definitionIndex());
+  this->definitionsTimer = new QTimer(this);
+  this->definitionsTimer->setSingleShot(true);
+  this->definitionsTimer->setInterval(DefinitionsDelayMs);
+  connect(definitionsTimer, SIGNAL(timeout()), this, SLOT(refreshDefinitions()));
+  
+  lexer.loadKeywords(kw);
+  //no rehighlight here: attaching the document has already scheduled one
+  this->m_theme = themeFromSettings();
+}
+
+highlighter::~highlighter()
+{
+   //the worker reads our lexer
+   tokenizer->waitForFinished();
+}
+
+void highlighter::setEditor(QTextEdit *edit)
+{
+   this->editor = edit;
+   this->visibleRangeDirty = true;
+   connect(edit->verticalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(viewportMoved()));
+   connect(edit->verticalScrollBar(), SIGNAL(rangeChanged(int,int)), this, SLOT(viewportMoved()));
+}
+
+bool highlighter::isLazy() const
+{
+   return editor != NULL && document() != NULL && document()->blockCount() > lazyThreshold;
+}
+
+void highlighter::viewportMoved()
+{
+   //the visible range is only looked up from the idle slot, never while highlighting
+   visibleRangeDirty = true;
+   if(isLazy())
+      idleTimer->start();
+}
+
+void highlighter::highlightPendingChunk()
+{
+   QTextDocument *doc = document();
+   if(doc == NULL || editor == NULL || editor->document() != doc)
+   {
+      idleTimer->stop();
+      return;
+   }
+   
+   QElapsedTimer elapsed;
+   elapsed.start();
+   
+   //what is on screen first...
+   if(visibleRangeDirty)
+   {
+      visibleRangeDirty = false;
+      firstVisible = editor->cursorForPosition(QPoint(0, 0)).blockNumber();
+      lastVisible = editor->cursorForPosition(QPoint(0, editor->viewport()->height())).blockNumber();
+      
+      int count = lastVisible - firstVisible + 2 * ViewportMargin;
+      QTextBlock block = doc->findBlockByNumber(qMax(0, firstVisible - ViewportMargin));
+      for(int i = 0; i <= count && block.isValid(); i++)
+      {
+         formatPendingBlock(block);
+         block = block.next();
+      }
+   }
+   
+   //...then the rest of the document, one slice at a time
+   QTextBlock block = doc->findBlockByNumber(pendingFrom);
+   bool waiting = false;
+   while(block.isValid() && elapsed.elapsed() < IdleSliceMs)
+   {
+      highlightData *data = static_cast<highlightData*>(block.userData());
+      if(data != NULL && !data->formatted)
+      {
+         if(!hasFreshTokens(block, data))
+         {
+            //the next blocks get lexed in the background, formatting resumes once they are
+            if(!tokenizer->isRunning())
+               startTokenizer(block);
+            waiting = true;
+            break;
+         }
+         formatPendingBlock(block);
+      }
+      block = block.next();
+   }
+   
+   if(block.isValid())
+      pendingFrom = block.blockNumber();
+   if(!block.isValid() || waiting)
+      idleTimer->stop();
+}
+
+bool highlighter::hasFreshTokens(const QTextBlock &block, highlightData *data) const
+{
+   QTextBlock prev = block.previous();
+   int entryState = prev.isValid() ? prev.userState() : -1;
+   return data->tokensValid && data->revision == block.revision() && data->length == block.length() - 1
+      && data->entryState == entryState;
+}
+
+void highlighter::startTokenizer(QTextBlock block)
+{
+   if(staleFrom >= 0 && block.blockNumber() <= staleFrom)
+      staleFrom = -1;
+   if(!block.isValid()) //the stale blocks were deleted since
+      return;
+   QTextBlock prev = block.previous();
+   tokenizerJob job;
+   job.entryState = prev.isValid() ? prev.userState() : -1;
+   tokenizingFrom = block.blockNumber();
+   for(int i = 0; i < TokenizerBatch && block.isValid(); i++)
+   {
+      job.texts << block.text();
+      job.revisions << block.revision();
+      block = block.next();
+   }
+   tokenizer->setFuture(QtConcurrent::run(tokenizeBlocks, &lexer, job));
+}
+
+void highlighter::tokenizerFinished()
+{
+   QVector<tokenizedBlock> result = tokenizer->result();
+   QTextDocument *doc = document();
+   if(doc == NULL)
+      return;
+   
+   QTextBlock block = doc->findBlockByNumber(tokenizingFrom);
+   for(int i = 0; i < result.count() && block.isValid(); i++)
+   {
+      const tokenizedBlock &blk = result.at(i);
+      highlightData *data = static_cast<highlightData*>(block.userData());
+      QTextBlock prev = block.previous();
+      
+      //kept when still right for the block as it is now: highlightBlock then uses them instead of lexing;
+      //blocks edited since the snapshot, or entered in another state, keep their synchronous fallback
+      if(data != NULL && block.revision() == blk.revision && block.length() - 1 == blk.length
+         && (prev.isValid() ? prev.userState() : -1) == blk.entryState)
+      {
+         data->tokens = blk.tokens;
+         data->tokensValid = true;
+         data->revision = blk.revision;
+         data->length = blk.length;
+         data->entryState = blk.entryState;
+         data->exitState = blk.exitState;
+         updateDefinitions(block, data, block.text());
+      }
+      block = block.next();
+   }
+   
+   //edits made while the job ran left blocks to lex
+   if(staleFrom >= 0)
+      startTokenizer(doc->findBlockByNumber(staleFrom));
+   if(isLazy())
+      idleTimer->start();
+}
 
-  this->updateColorSettings();
-  createKeywordArray(kw);
+void highlighter::documentChanged(int from, int charsRemoved, int charsAdded)
+{
+   Q_UNUSED(from);
+   Q_UNUSED(charsRemoved);
+   Q_UNUSED(charsAdded);
+   
+   //the blocks below the edit whose state changed were only lexed for it, their tokens come from the worker
+   QTextDocument *doc = document();
+   if(doc != NULL && staleFrom >= 0 && !tokenizer->isRunning())
+      startTokenizer(doc->findBlockByNumber(staleFrom));
+}
+
+void highlighter::updateDefinitions(const QTextBlock &block, highlightData *data, const QString &text)
+{
+   //called whenever the tokens of a block change
+   QVector<blockDefinition> defs;
+   QSet<QString> uses;
+   for(int i = 0; i < data->tokens.count(); i++)
+   {
+      const camlToken &tok = data->tokens.at(i);
+      if(tok.construct >= UserFunction && tok.construct <= UserConstructor)
+      {
+         blockDefinition def;
+         def.name = text.mid(tok.start, tok.length);
+         def.construct = tok.construct;
+         defs << def;
+      }
+      else if(tok.construct == camlLexer::Identifier)
+         uses.insert(text.mid(tok.start, tok.length));
+   }
+   
+   data->block = block;
+   data->index = definitions;
+   definitions->setUses(data, uses);
    
-  this->escapeSequence = false;
-  this->hasSearchRule = false;
+   bool same = (defs.count() == data->definitions.count());
+   for(int i = 0; i < defs.count() && same; i++)
+      same = (defs.at(i).name == data->definitions.at(i).name && defs.at(i).construct == data->definitions.at(i).construct);
+   if(!same)
+   {
+      for(int i = 0; i < data->definitions.count(); i++)
+         definitions->remove(data->definitions.at(i).name, data->definitions.at(i).construct);
+      data->definitions = defs;
+      for(int i = 0; i < defs.count(); i++)
+         definitions->add(defs.at(i).name, defs.at(i).construct);
+   }
+   
+   //also catches the declarations of blocks that were just deleted
+   if(definitions->hasChanges())
+      definitionsTimer->start();
+}
+
+void highlighter::refreshDefinitions()
+{
+   //reformats the blocks that use a name whose construct changed, and only those
+   QSet<QString> changed = definitions->takeChanges();
+   QTextDocument *doc = document();
+   if(doc == NULL || changed.isEmpty())
+      return;
+   
+   QSet<highlightData*> users;
+   for(QSet<QString>::const_iterator it = changed.constBegin(); it != changed.constEnd(); ++it)
+      users += definitions->usersOf(*it);
+   
+   bool lazy = isLazy();
+   for(QSet<highlightData*>::const_iterator it = users.constBegin(); it != users.constEnd(); ++it)
+   {
+      //uses are recorded along with the tokens, stale ones are skipped here
+      highlightData *data = *it;
+      QTextBlock block = data->block;
+      if(!block.isValid() || block.userData() != data || !data->formatted || !data->tokensValid)
+         continue;
+      
+      data->formatted = false;
+      int blockNumber = block.blockNumber();
+      if(!lazy || (blockNumber >= firstVisible - ViewportMargin && blockNumber <= lastVisible + ViewportMargin))
+         formatPendingBlock(block);
+      else
+      {
+         if(!idleTimer->isActive() || blockNumber < pendingFrom)
+            pendingFrom = blockNumber;
+         idleTimer->start();
+      }
+   }
+}
+
+void highlighter::formatPendingBlock(const QTextBlock &block)
+{
+   highlightData *data = static_cast<highlightData*>(block.userData());
+   if(data != NULL && !data->formatted)
+   {
+      forceFormat = true;
+      rehighlightBlock(block);
+      forceFormat = false;
+   }
 }
 
 void highlighter::updateColorSettings()
 {
-  //called after settings are changed or at build-up
+  //called after settings are changed
+  setTheme(themeFromSettings());
+}
+
+highlighter::Theme highlighter::themeFromSettings() const
+{
   QStringList colorsToSet;
-  colorsToSet << "variableDec" << "loop" << "comment" << "preproc" << "boolean" << "string" << "char" << "builtInType" << "builtInFunction" << "searchResult";
+  colorsToSet << "variableDec" << "loop" << "comment" << "preproc" << "boolean" << "string" << "char" << "builtInType" << "builtInFunction" << "searchResult" << "userFunction" << "userType" << "userConstructor";
   QStringList defaultColors;
-  defaultColors << "186,19,155" << "0,163,49" << "181,181,181" << "0,224,49" << "0,75,255" << "255,0,0" << "255,0,0" << "0,21,156" << "0,21,156" << "255,255,0";
+  defaultColors << "186,19,155" << "0,163,49" << "181,181,181" << "0,224,49" << "0,75,255" << "255,0,0" << "255,0,0" << "0,21,156" << "0,21,156" << "255,255,0" << "128,64,0" << "0,128,128" << "128,0,128";
   QStringList helpers;
-  helpers << tr("Variable declarations") << tr("Loops") << tr("Comments") << tr("Preprocessor commands") << tr("Booleans") << tr("Strings") << tr("Characters") << tr("Built in types") << tr("Built in functions") << tr("Search results");
-  bool bold[] = { false, true, false, false, true, false, false, false, false, true };
-  bool italics[] = { false, false, true, false, false, false, false, false, false, false };
-  bool isBackground[] = { false, false, false, false, false, false, false, false, false, true };
+  helpers << tr("Variable declarations") << tr("Loops") << tr("Comments") << tr("Preprocessor commands") << tr("Booleans") << tr("Strings") << tr("Characters") << tr("Built in types") << tr("Built in functions") << tr("Search results") << tr("User-defined functions") << tr("User-defined types") << tr("User-defined constructors");
+  bool bold[] = { false, true, false, false, true, false, false, false, false, true, false, false, false };
+  bool italics[] = { false, false, true, false, false, false, false, false, false, false, false, false, false };
+  bool isBackground[] = { false, false, false, false, false, false, false, false, false, true, false, false, false };
   
+  //constructs with an unreadable color keep their current format
+  Theme theme = m_theme;
   for(int i = 0; i < colorsToSet.count(); i++)
   {
      QString curColor = settings->value("Colors/" + colorsToSet[i], defaultColors[i]).toString();
@@ -55,149 +413,95 @@ void highlighter::updateColorSettings()
         
         if(bold[i]) charFormat.setFontWeight(QFont::Bold);
         if(italics[i]) charFormat.setFontItalic(true);
-        setFormatFor((Construct)i, charFormat);
+        theme.formats[i] = charFormat;
      }
      delete[] colors;
   }
+  return theme;
 }
 
 void highlighter::setFormatFor(Construct construct, const QTextCharFormat &format)
 {
-   m_formats[construct] = format;
-   rehighlight();
+   Theme theme = m_theme;
+   theme.formats[construct] = format;
+   setTheme(theme);
 }
 
-void highlighter::highlightBlock(const QString &text)
+void highlighter::setTheme(const Theme &theme)
 {
-   int state = previousBlockState();
-   int len = text.length();
-   int start = 0;
-   int pos = 0;
-   
-   foreach (const HighlightingRule &rule, highlightingRules) {
-      QRegExp expression(rule.pattern);
-      int index = expression.indexIn(text);
-      while (index >= 0) {
-         int length = expression.matchedLength();
-         QTextCharFormat fmt = m_formats[rule.format];
-         setFormat(index, length, fmt);
-         index = expression.indexIn(text, index + length + ((length == 0)?1:0)); //during testing, a zero-length match happened (with (a|b)*). If mu is in the recognized language, then we should skip it.
+   bool changed = false;
+   for(int i = 0; i <= LastConstruct; i++)
+   {
+      if(m_theme.formats[i] != theme.formats[i])
+      {
+         m_theme.formats[i] = theme.formats[i];
+         changed = true;
       }
    }
    
-   while (pos < len) {
-      switch (state) {
-         case NormalState:
-         default:
-            while (pos < len) {
-               if (text.mid(pos, 2) == "(*") {
-                  state = InComment;
-                  break;
-               } else if (text.at(pos) == '"') {
-                  state = InString;
-                  setFormat(pos, 1, m_formats[String]);
-                  ++pos;
-                  break;
-               } else if (pos == 0 && text.at(pos) == '#') {
-                  state = InPreprocessor;
-                  setFormat(pos, 1, m_formats[Preprocessor]);
-                  ++pos;
-                  break;
-               } else if (text.at(pos) == '`') {
-                  state = InChar;
-                  setFormat(pos, 1, m_formats[Char]);
-                  ++pos;
-                  break;
-               } else {
-                  //keywords are better handled elsewhere
-                  ++pos;
+   if(changed)
+      rehighlight();
+}
 
-               }
-            }
-            break;
-         case InComment:
-            start = pos;
-            while (pos < len) {
-               if (text.mid(pos, 2) == "*)") {
-                  pos += 2;
-                  state = NormalState;
-                  break;
-               } else {
-                  ++pos;
-               }
-            }
-            setFormat(start, pos - start,
-                      m_formats[Comment]);
-            break;
-         case InString:
-            start = pos;
-            while (pos < len) {
-               if(escapeSequence)
-               {
-                  escapeSequence = false;
-                  ++pos;
-               }
-               else
-               {
-                  if (text.at(pos) == '"') {
-                     pos += 1;
-                     state = NormalState;
-                     break;
-                  } else if(text.at(pos) == '\\') {
-                     escapeSequence = true;
-                     ++pos;
-                  } else {
-                     ++pos;
-                  }
-               }
-            }
-            setFormat(start, pos - start,
-                      m_formats[String]);
-            break;	
-         case InChar:
-            start = pos;
-            while (pos < len) {
-               if(escapeSequence)
-               {
-                  escapeSequence = false;
-                  ++pos;
-               }
-               else
-               {
-                  if (text.at(pos) == '`') {
-                     pos += 1;
-                     state = NormalState;
-                     break;
-                  } else if(text.at(pos) == '\\') {
-                     escapeSequence = true;
-                     ++pos;
-                  } else {
-                     ++pos;
-                  }
-               }
-            }
-            setFormat(start, pos - start,
-                      m_formats[Char]);
-            break;
-         case InPreprocessor:
-            start = pos;
-            while (pos < len) {
-               if (text.mid(pos,2) == ";;") {
-                  pos += 2;
-                  state = NormalState;
-                  break;
-               } else {
-                  ++pos;
-               }
-            }
-            setFormat(start, pos - start,
-                      m_formats[Preprocessor]);
-            break;
-      }
+void highlighter::highlightBlock(const QString &text)
+{
+   QTextBlock block = currentBlock();
+   int blockNumber = block.blockNumber();
+   bool doFormat = !isLazy() || forceFormat || (blockNumber >= firstVisible - ViewportMargin && blockNumber <= lastVisible + ViewportMargin);
+   int entryState = previousBlockState();
+   
+   highlightData *data = static_cast<highlightData*>(currentBlockUserData());
+   if(data == NULL)
+   {
+      data = new highlightData();
+      setCurrentBlockUserData(data);
+   }
+   data->formatted = doFormat;
+   
+   if(!doFormat) //the block state is still computed, only the formatting is left for later
+   {
+      if(!idleTimer->isActive() || blockNumber < pendingFrom)
+         pendingFrom = blockNumber;
+      idleTimer->start();
    }
+   else if(idleTimer->isActive() && blockNumber < pendingFrom)
+      pendingFrom = blockNumber; //blocks may have been removed above the pending ones
    
-   setCurrentBlockState(state);
+   bool cached = data->tokensValid && data->revision == block.revision() && data->length == text.length()
+      && data->entryState == entryState;
+   if(!cached)
+   {
+      //no result from the worker for this revision: synchronous fallback,
+      //blocks that are not formatted yet only get their state and leave their tokens to the worker
+      if(!doFormat && (staleFrom < 0 || blockNumber < staleFrom))
+         staleFrom = blockNumber;
+      data->exitState = lexer.lex(text, entryState, doFormat ? &data->tokens : NULL);
+      data->tokensValid = doFormat;
+      if(!doFormat)
+         data->tokens.clear();
+      data->revision = block.revision();
+      data->length = text.length();
+      data->entryState = entryState;
+      
+      //blocks lexed without tokens keep their declarations until they are formatted
+      if(doFormat)
+         updateDefinitions(block, data, text);
+   }
+   
+   if(doFormat)
+   {
+      for(int i = 0; i < data->tokens.count(); i++)
+      {
+         const camlToken &tok = data->tokens.at(i);
+         int construct = tok.construct;
+         if(construct == camlLexer::Identifier)
+            construct = definitions->constructFor(QString::fromRawData(text.constData() + tok.start, tok.length));
+         if(construct >= 0 && construct <= LastConstruct)
+            setFormat(tok.start, tok.length, m_theme.formats[construct]);
+      }
+   }
    
+   setCurrentBlockState(data->exitState);
 }
 
 bool highlighter::insideWord(QString str, int start, int len)
@@ -217,58 +521,4 @@ bool highlighter::insideWord(QString str, int start, int len)
       }
    }
    return false;
-}
-
-void highlighter::createKeywordArray(QStringList *lst)
-{
-   int len = lst->count();
-   numKW = len;
-   
-   HighlightingRule rule;
-   
-   for(int i = 0; i < len; i++)
-   {
-      if(lst->at(i).at(0) == '#') //comment
-         continue;
-      
-      QStringList spl = lst->at(i).split(";", QString::SkipEmptyParts);
-      if(spl.count() == 2)
-      {
-         //handle special chars in regexps 
-         QString cleanPattern = QRegExp::escape(spl[0]);
-         
-         bool hasLetters = false;
-         QRegExp keywordWithLetters("[a-zA-z]");
-         if(keywordWithLetters.indexIn(spl[0]) >= 0)
-            hasLetters = true;
-         
-         QString pattern = (hasLetters ? "\\b" : "") + cleanPattern + (hasLetters ? "\\b" : "");
-         rule.pattern = QRegExp(pattern);
-         rule.format =  static_cast<Construct>(spl[1].toInt());
-         highlightingRules.append(rule);
-      }
-
-   }
-   
-}
-
-void highlighter::addSearchRule(QRegExp regexp)
-{
-   if(hasSearchRule)
-      undoSearchRule();
-   HighlightingRule rule;
-   rule.pattern = regexp;
-   rule.format = SearchResult;
-   highlightingRules.append(rule);
-   hasSearchRule = true;
-   rehighlight();
-}
-
-void highlighter::undoSearchRule()
-{
-   if(hasSearchRule) {
-      highlightingRules.erase(highlightingRules.end() - 1);
-      rehighlight();
-   }
-   hasSearchRule = false;
 }
\ No newline at end of file
@@ -16,11 +16,103 @@
 
 #include <QSyntaxHighlighter>
 #include <QSettings>
+#include <QHash>
+#include <QSet>
+#include <QSharedPointer>
+#include <QTextEdit>
+#include <QScrollBar>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QtConcurrentRun>
 #include "common.h"
+#include "camllexer.h"
 
 #ifndef HIGHLIGHTER_H
 #define HIGHLIGHTER_H
 
+class highlightData;
+
+/* Names bound by the top-level declarations of a document. Each declaring
+ * block counts once, so a name stays defined as long as one of its
+ * declarations is left. The blocks using each name are kept as well, so
+ * that a change only reaches the blocks it concerns. */
+class definitionIndex
+{
+public:
+  void add(const QString &name, int construct);
+  void remove(const QString &name, int construct);
+  int constructFor(const QString &name) const //-1 for names declared nowhere
+  { return resolved.value(name, -1); }
+  
+  //names whose construct changed since the last call
+  bool hasChanges() const
+  { return !changed.isEmpty(); }
+  QSet<QString> takeChanges();
+  
+  //the identifiers a block uses, replacing the ones it used before
+  void setUses(highlightData *data, const QSet<QString> &names);
+  QSet<highlightData*> usersOf(const QString &name) const
+  { return users.value(name); }
+  
+private:
+  void resolve(const QString &name);
+  
+  QHash<QString, int> counts[3]; //by construct, from highlighter::UserFunction on
+  QHash<QString, int> resolved;
+  QSet<QString> changed;
+  QHash<QString, QSet<highlightData*> > users;
+};
+
+struct blockDefinition {
+  QString name;
+  int construct;
+};
+
+class highlightData : public QTextBlockUserData
+{
+public:
+  highlightData() : formatted(false), tokensValid(false), revision(-1), entryState(-1), exitState(-1), length(-1) {}
+  ~highlightData()
+  {
+     //deleted blocks take their declarations and uses with them
+     for(int i = 0; i < definitions.count() && index; i++)
+        index->remove(definitions.at(i).name, definitions.at(i).construct);
+     if(index)
+        index->setUses(this, QSet<QString>());
+  }
+  bool formatted; //false when only the block state is known (see highlighter::isLazy)
+  
+  //token cache, valid for one revision of the block text and one entry state
+  bool tokensValid;
+  int revision;
+  int entryState;
+  int exitState;
+  int length;
+  QVector<camlToken> tokens;
+  
+  //what the block declares and uses, set along with the tokens
+  QVector<blockDefinition> definitions;
+  QSet<QString> uses;
+  QSharedPointer<definitionIndex> index;
+  QTextBlock block; //the block of this data, as of its last lexing
+};
+
+//consecutive blocks handed to the background tokenizer
+struct tokenizerJob {
+  int entryState;
+  QVector<QString> texts;
+  QVector<int> revisions;
+};
+
+struct tokenizedBlock {
+  int revision;
+  int entryState;
+  int exitState;
+  int length;
+  QVector<camlToken> tokens;
+};
+
 class highlighter : public QSyntaxHighlighter
 {
   Q_OBJECT
@@ -37,49 +129,78 @@ public:
     BuiltInType,
     BuiltInFunction,
     SearchResult,
-    LastConstruct = SearchResult
+    UserFunction,
+    UserType,
+    UserConstructor,
+    LastConstruct = UserConstructor
+  };
+  
+  //the formats of every construct, applied at once with setTheme
+  struct Theme {
+    QTextCharFormat formats[LastConstruct + 1];
   };
   
   highlighter(QTextDocument *document, QStringList *kw, QSettings *settings);
+  ~highlighter();
   
   void setFormatFor(Construct construct,
 		    const QTextCharFormat &format);
   QTextCharFormat formatFor(Construct construct) const
-  { return m_formats[construct]; }
+  { return m_theme.formats[construct]; }
   
-  
-    struct HighlightingRule
-    {
-        QRegExp pattern;
-        Construct format;
-    };
-    
+  //rehighlights the document once, and only if a format actually changed
+  void setTheme(const Theme &theme);
+  const Theme &theme() const
+  { return m_theme; }
+  Theme themeFromSettings() const;
   
   void updateColorSettings();
-  void addSearchRule(QRegExp regexp);
-  void undoSearchRule();
   
-protected:
-  enum State {
-    NormalState = -1,
-    InComment,
-    InString,
-    InChar,
-    InPreprocessor
-  };
+  /* On large documents, only the blocks around the editor's viewport are
+   * formatted right away; the others are formatted by small idle slices. */
+  void setEditor(QTextEdit *edit);
+  bool isLazy() const;
   
+protected:
   void highlightBlock(const QString &text);
 
+private slots:
+  void viewportMoved();
+  void highlightPendingChunk();
+  void tokenizerFinished();
+  void documentChanged(int from, int charsRemoved, int charsAdded);
+  void refreshDefinitions();
   
 private:
-   QVector<HighlightingRule> highlightingRules;
-   bool escapeSequence;
-   QTextCharFormat m_formats[LastConstruct + 1];
+   enum {
+      ViewportMargin = 100, //blocks formatted above and below the visible ones
+      IdleSliceMs = 4, //time spent formatting per event loop turn
+      TokenizerBatch = 1000, //blocks lexed per background job
+      DefinitionsDelayMs = 300 //typing a name only reformats its uses once the typing stops
+   };
+   
+   void formatPendingBlock(const QTextBlock &block);
+   bool hasFreshTokens(const QTextBlock &block, highlightData *data) const;
+   void startTokenizer(QTextBlock block);
+   void updateDefinitions(const QTextBlock &block, highlightData *data, const QString &text);
+
+   camlLexer lexer;
+   QFutureWatcher< QVector<tokenizedBlock> > *tokenizer;
+   int tokenizingFrom;
+   int staleFrom; //first block lexed for its state only since the last job started, -1 if none
+   QSharedPointer<definitionIndex> definitions;
+   QTimer *definitionsTimer;
+   Theme m_theme;
    bool insideWord(QString str, int start, int len);
-   void createKeywordArray(QStringList *lst);
-   int numKW;
    QSettings *settings;
-   bool hasSearchRule;
+   QTextEdit *editor;
+   QTimer *idleTimer;
+   int lazyThreshold;
+   int pendingFrom;
+   int firstVisible;
+   int lastVisible;
+   bool visibleRangeDirty;
+   bool forceFormat;
 };
 
 #endif
\ No newline at end of file
@@ -14,12 +14,44 @@
 // You should have received a copy of the GNU General Public License
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <QPainter>
+#include <QStyleOptionSlider>
 #include "inputzone.h"
 
+void markerScrollBar::setMarkers(const QVector<qreal> &markers)
+{
+   this->markers = markers;
+   update();
+}
+
+void markerScrollBar::paintEvent(QPaintEvent *event)
+{
+   QScrollBar::paintEvent(event);
+   if(markers.isEmpty())
+      return;
+   
+   QStyleOptionSlider opt;
+   initStyleOption(&opt);
+   QRect groove = style()->subControlRect(QStyle::CC_ScrollBar, &opt, QStyle::SC_ScrollBarGroove, this);
+   
+   QPainter painter(this);
+   QColor tick = palette().color(QPalette::Highlight);
+   int lastY = -1;
+   for(int i = 0; i < markers.count(); i++)
+   {
+      int y = groove.top() + (int)(markers.at(i) * (groove.height() - 2));
+      if(y == lastY) //thousands of results end up on the same few pixels
+         continue;
+      painter.fillRect(groove.left() + 2, y, groove.width() - 4, 2, tick);
+      lastY = y;
+   }
+}
+
 InputZone::InputZone() :
     QTextEdit()
 {
    handleEnter = false;
+   setVerticalScrollBar(new markerScrollBar(this)); //found again through verticalScrollBar()
 }
 
 void InputZone::keyPressEvent(QKeyEvent *event)
@@ -19,6 +19,23 @@
 
 #include <QTextEdit>
 #include <QKeyEvent>
+#include <QScrollBar>
+#include <QVector>
+
+//a scroll bar with tick marks, e.g. where the search results are
+class markerScrollBar : public QScrollBar
+{
+    Q_OBJECT
+public:
+    markerScrollBar(QWidget *parent = 0) : QScrollBar(Qt::Vertical, parent) {}
+    //positions as fractions of the document, from 0 (top) to 1 (bottom)
+    void setMarkers(const QVector<qreal> &markers);
+    void clearMarkers() { setMarkers(QVector<qreal>()); }
+protected:
+    void paintEvent(QPaintEvent *event);
+private:
+    QVector<qreal> markers;
+};
 
 class InputZone : public QTextEdit
 {
@@ -0,0 +1,547 @@
+// keywords_table.h - Built-in keywords, generated from the "keywords" file
+// by genkeywords.awk. Do not edit: edit "keywords" instead.
+
+#ifndef KEYWORDS_TABLE_H
+#define KEYWORDS_TABLE_H
+
+struct builtinKeyword {
+   const char *word;
+   int length;
+   int construct;
+};
+
+static constexpr int builtinKeywordBits = 9;
+static constexpr int builtinKeywordBuckets = 58;
+
+static constexpr unsigned int builtinKeywordMultipliers[builtinKeywordBuckets] = {
+   5, 3, 13, 13, 3, 3, 3, 13, 5, 1, 11, 7, 3, 5, 19, 1, 1, 3, 11, 5, 7,
+   11, 25, 5, 1, 9, 3, 5, 3, 3, 5, 5, 7, 5, 1, 1, 1, 25, 13, 21, 1, 5, 11,
+   1, 1, 9, 19, 3, 1, 13, 15, 3, 41, 29, 1, 25, 17, 1,
+};
+
+static constexpr builtinKeyword builtinKeywords[1 << builtinKeywordBits] = {
+   { "hd", 2, 8 },
+   { "set_nth_char", 12, 8 },
+   { "of", 2, 0 },
+   { "do", 2, 1 },
+   { "sub_float", 9, 8 },
+   { "in", 2, 0 },
+   { 0, 0, -1 },
+   { "tl", 2, 8 },
+   { 0, 0, -1 },
+   { "or", 2, 4 },
+   { "not", 3, 4 },
+   { "pos_out", 7, 8 },
+   { "if", 2, 1 },
+   { "to", 2, 1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "eq_string", 9, 8 },
+   { "vect_assign", 11, 8 },
+   { 0, 0, -1 },
+   { "min_int", 7, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "stream_of_channel", 17, 8 },
+   { "prerr_string", 12, 8 },
+   { "float", 5, 7 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "close_in", 8, 8 },
+   { "Parse_error", 11, 0 },
+   { "rindex_char_from", 16, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "Parse_failure", 13, 0 },
+   { 0, 0, -1 },
+   { "union", 5, 8 },
+   { 0, 0, -1 },
+   { "nth_char", 8, 8 },
+   { 0, 0, -1 },
+   { "tanh", 4, 8 },
+   { "char", 4, 7 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "it_list", 7, 8 },
+   { "eq_int", 6, 8 },
+   { 0, 0, -1 },
+   { "read_int", 8, 8 },
+   { "abs", 3, 8 },
+   { "cos", 3, 8 },
+   { "end", 3, 1 },
+   { "combine", 7, 8 },
+   { 0, 0, -1 },
+   { "le_string", 9, 8 },
+   { "mod", 3, 8 },
+   { 0, 0, -1 },
+   { "int_of_float", 12, 8 },
+   { "int_of_char", 11, 8 },
+   { "tan", 3, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "pred", 4, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "string", 6, 7 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "input_line", 10, 8 },
+   { "prerr_endline", 13, 8 },
+   { 0, 0, -1 },
+   { "prerr_char", 10, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "mod_float", 9, 8 },
+   { "stream", 6, 7 },
+   { "for", 3, 1 },
+   { "modf", 4, 8 },
+   { "output_binary_int", 17, 8 },
+   { "for_all", 7, 8 },
+   { 0, 0, -1 },
+   { "map_combine", 11, 8 },
+   { "do_stream", 9, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "open_out", 8, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "sub_int", 7, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "index_char", 10, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "float_of_string", 15, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "flat_map", 8, 8 },
+   { "lshift_right", 12, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "close_out", 9, 8 },
+   { 0, 0, -1 },
+   { "out_channel_length", 18, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "bool", 4, 7 },
+   { "floor", 5, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "while", 5, 1 },
+   { 0, 0, -1 },
+   { "when", 4, 0 },
+   { 0, 0, -1 },
+   { "really_input", 12, 8 },
+   { 0, 0, -1 },
+   { "subtract", 8, 8 },
+   { "downto", 6, 1 },
+   { "print_int", 9, 8 },
+   { "assq", 4, 8 },
+   { "mult_float", 10, 8 },
+   { "fill_vect", 9, 8 },
+   { 0, 0, -1 },
+   { "list_length", 11, 8 },
+   { "print_string", 12, 8 },
+   { "read_float", 10, 8 },
+   { "fill_string", 11, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "acos", 4, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "sin", 3, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "failwith", 8, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "max_int", 7, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "let", 3, 0 },
+   { "log", 3, 8 },
+   { "split", 5, 8 },
+   { "lsr", 3, 8 },
+   { 0, 0, -1 },
+   { "string_for_read", 15, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "asin", 4, 8 },
+   { "open_in", 7, 8 },
+   { "rec", 3, 0 },
+   { 0, 0, -1 },
+   { "snd", 3, 8 },
+   { "input_binary_int", 16, 8 },
+   { 0, 0, -1 },
+   { "gt_string", 9, 8 },
+   { "stream_check", 12, 8 },
+   { 0, 0, -1 },
+   { "fun", 3, 1 },
+   { 0, 0, -1 },
+   { "make_vect", 9, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "list", 4, 7 },
+   { "map_vect", 8, 8 },
+   { 0, 0, -1 },
+   { "else", 4, 1 },
+   { "prerr_float", 11, 8 },
+   { "input_byte", 10, 8 },
+   { 0, 0, -1 },
+   { "compare_strings", 15, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "ge_string", 9, 8 },
+   { "output_byte", 11, 8 },
+   { 0, 0, -1 },
+   { "open_in_gen", 11, 8 },
+   { "create_string", 13, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "function", 8, 1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "cosh", 4, 8 },
+   { "list_of_vect", 12, 8 },
+   { "blit_string", 11, 8 },
+   { "exception", 9, 0 },
+   { "unit", 4, 7 },
+   { 0, 0, -1 },
+   { "land", 4, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "output_char", 11, 8 },
+   { "ldexp", 5, 8 },
+   { 0, 0, -1 },
+   { "concat", 6, 8 },
+   { "it_list2", 8, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "match", 5, 1 },
+   { "sub_vect", 8, 8 },
+   { "mem", 3, 8 },
+   { 0, 0, -1 },
+   { "print_float", 11, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "lt_string", 9, 8 },
+   { 0, 0, -1 },
+   { "memq", 4, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "open_descriptor_in", 18, 8 },
+   { 0, 0, -1 },
+   { "read_line", 9, 8 },
+   { "and", 3, 0 },
+   { 0, 0, -1 },
+   { "make_matrix", 11, 8 },
+   { "char_for_read", 13, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "done", 4, 1 },
+   { 0, 0, -1 },
+   { "seek_in", 7, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "ref", 3, 0 },
+   { "make_string", 11, 8 },
+   { "succ", 4, 8 },
+   { "input_char", 10, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "init_vect", 9, 8 },
+   { "stream_from", 11, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "minus_float", 11, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "sinh", 4, 8 },
+   { 0, 0, -1 },
+   { "lsl", 3, 8 },
+   { "le_int", 6, 8 },
+   { "max", 3, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "where", 5, 0 },
+   { "prerr_int", 9, 8 },
+   { "incr", 4, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "sqrt", 4, 8 },
+   { "prerr_newline", 13, 8 },
+   { 0, 0, -1 },
+   { "replace_string", 14, 8 },
+   { "rev", 3, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "with", 4, 1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "try", 3, 1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "min", 3, 8 },
+   { "stream_get", 10, 8 },
+   { "add_float", 9, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "print_endline", 13, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "abs_float", 9, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "string_of_int", 13, 8 },
+   { 0, 0, -1 },
+   { "do_vect", 7, 8 },
+   { 0, 0, -1 },
+   { "neq_int", 7, 8 },
+   { 0, 0, -1 },
+   { "add_int", 7, 8 },
+   { 0, 0, -1 },
+   { "input", 5, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "output_string", 13, 8 },
+   { 0, 0, -1 },
+   { "div_float", 9, 8 },
+   { "exceptq", 7, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "blit_vect", 9, 8 },
+   { "do_list_combine", 15, 8 },
+   { "type", 4, 0 },
+   { "assoc", 5, 8 },
+   { "lt_int", 6, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "Failure", 7, 0 },
+   { "map", 3, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "do_list", 7, 8 },
+   { "atan2", 5, 8 },
+   { "index_char_from", 15, 8 },
+   { "vect_item", 9, 8 },
+   { "stream_of_string", 16, 8 },
+   { "sub_string", 10, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "false", 5, 4 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "flush", 5, 8 },
+   { 0, 0, -1 },
+   { "regexp", 6, 7 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "lxor", 4, 8 },
+   { "list_it", 7, 8 },
+   { 0, 0, -1 },
+   { "in_channel_length", 17, 8 },
+   { "output_compact_value", 20, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "end_of_stream", 13, 8 },
+   { "lnot", 4, 8 },
+   { "intersect", 9, 8 },
+   { "raise", 5, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "log10", 5, 8 },
+   { 0, 0, -1 },
+   { "index", 5, 8 },
+   { 0, 0, -1 },
+   { "string_of_float", 15, 8 },
+   { 0, 0, -1 },
+   { "neq_string", 10, 8 },
+   { 0, 0, -1 },
+   { "seek_out", 8, 8 },
+   { "float_of_int", 12, 8 },
+   { "lor", 3, 8 },
+   { "open_out_bin", 12, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "atan", 4, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "ceil", 4, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "mult_int", 8, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "do_list2", 8, 8 },
+   { 0, 0, -1 },
+   { "string_length", 13, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "open_descriptor_out", 19, 8 },
+   { "pos_in", 6, 8 },
+   { 0, 0, -1 },
+   { "gt_int", 6, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "frexp", 5, 8 },
+   { 0, 0, -1 },
+   { "concat_vect", 11, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "output", 6, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "char_of_int", 11, 8 },
+   { "mem_assoc", 9, 8 },
+   { "copy_vect", 9, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "invalid_arg", 11, 8 },
+   { "lshift_left", 11, 8 },
+   { 0, 0, -1 },
+   { "power", 5, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "begin", 5, 1 },
+   { 0, 0, -1 },
+   { "open_in_bin", 11, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "output_value", 12, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "exists", 6, 8 },
+   { 0, 0, -1 },
+   { "vect", 4, 7 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "rindex_char", 11, 8 },
+   { 0, 0, -1 },
+   { "ge_int", 6, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "input_value", 11, 8 },
+   { 0, 0, -1 },
+   { "print_char", 10, 8 },
+   { "exp", 3, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "div_int", 7, 8 },
+   { "fst", 3, 8 },
+   { 0, 0, -1 },
+   { "vect_of_list", 12, 8 },
+   { "then", 4, 1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "open_out_gen", 12, 8 },
+   { "stream_next", 11, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "int_of_string", 13, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "int", 3, 7 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "true", 4, 4 },
+   { "map_vect_list", 13, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "except", 6, 8 },
+   { 0, 0, -1 },
+   { 0, 0, -1 },
+   { "map2", 4, 8 },
+   { "print_newline", 13, 8 },
+};
+
+static constexpr int builtinOperatorCount = 4;
+
+static constexpr builtinKeyword builtinOperators[builtinOperatorCount + 1] = {
+   { "<-", 2, 0 },
+   { "->", 2, 0 },
+   { "&", 1, 4 },
+   { "||", 2, 4 },
+   { 0, 0, -1 }
+};
+
+#endif
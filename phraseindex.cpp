@@ -0,0 +1,156 @@
+// phraseindex.cpp - Where the top-level phrases of a document end
+// This file is part of LemonCaml - Copyright (C) 2012-2014 Corentin FERRY
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <limits.h>
+#include <algorithm>
+#include "phraseindex.h"
+
+phraseIndex::phraseIndex(QTextDocument *document, QObject *parent) : QObject(parent)
+{
+   this->document = document;
+   this->terminatedDirty = true;
+   
+   documentChanged(0, 0, document->characterCount());
+   connect(document, SIGNAL(contentsChange(int,int,int)), this, SLOT(documentChanged(int,int,int)));
+}
+
+int phraseIndex::scan(const QString &text, int state, QVector<int> *ends) const
+{
+   //the highlighter's rules, keeping only the comment or string open at the end of the line
+   int end = lexer.lex(text, state, NULL, ends);
+   if(end == camlLexer::NormalState || (end & camlLexer::ModeMask) == 0)
+      return camlLexer::NormalState;
+   return end & ~((camlLexer::DeclarationMask << camlLexer::DeclarationShift) | (camlLexer::LocalLetMask << camlLexer::LocalLetShift));
+}
+
+void phraseIndex::documentChanged(int from, int charsRemoved, int charsAdded)
+{
+   Q_UNUSED(charsRemoved);
+   QTextBlock first = document->findBlock(from);
+   QTextBlock last = document->findBlock(from + charsAdded);
+   if(!first.isValid())
+      first = document->lastBlock();
+   if(!last.isValid())
+      last = document->lastBlock();
+   
+   //the blocks from first to last replace as many blocks, give or take the change in block count
+   int firstNumber = first.blockNumber();
+   int lastNumber = last.blockNumber();
+   int delta = document->blockCount() - blocks.count();
+   if(delta > 0)
+   {
+      phraseBlock fresh;
+      fresh.revision = INT_MIN;
+      fresh.startState = INT_MIN;
+      fresh.endState = INT_MIN;
+      blocks.insert(firstNumber, delta, fresh);
+   }
+   else if(delta < 0)
+      blocks.remove(firstNumber, -delta);
+   if(delta != 0)
+      terminatedDirty = true;
+   
+   //past the edited blocks, carry on only while what is open at the start of a block changes
+   int state = (firstNumber > 0) ? blocks.at(firstNumber - 1).endState : (int)camlLexer::NormalState;
+   int number = firstNumber;
+   for(QTextBlock block = first; block.isValid(); block = block.next(), number++)
+   {
+      phraseBlock &pb = blocks[number];
+      if(pb.startState == state && (number > lastNumber || pb.revision == block.revision()))
+      {
+         if(number > lastNumber)
+            break;
+         state = pb.endState; //a format change, e.g. from the highlighter
+         continue;
+      }
+      
+      bool hadEnds = !pb.ends.isEmpty();
+      pb.revision = block.revision();
+      pb.startState = state;
+      pb.endState = scan(block.text(), state, &pb.ends);
+      if(hadEnds != !pb.ends.isEmpty())
+         terminatedDirty = true;
+      state = pb.endState;
+   }
+}
+
+void phraseIndex::updateTerminated()
+{
+   if(!terminatedDirty)
+      return;
+   terminatedDirty = false;
+   terminated.clear();
+   for(int i = 0; i < blocks.count(); i++)
+   {
+      if(!blocks.at(i).ends.isEmpty())
+         terminated << i;
+   }
+}
+
+int phraseIndex::previousEnd(int pos, bool strict)
+{
+   //the last end at or before pos (before it when strict), or -1
+   QTextBlock block = document->findBlock(pos);
+   if(!block.isValid())
+      block = document->lastBlock();
+   
+   const QVector<int> &ends = blocks.at(block.blockNumber()).ends;
+   for(int i = ends.count() - 1; i >= 0; i--)
+   {
+      int end = block.position() + ends.at(i);
+      if(end < pos || (end == pos && !strict))
+         return end;
+   }
+   
+   updateTerminated();
+   QVector<int>::const_iterator it = std::lower_bound(terminated.constBegin(), terminated.constEnd(), block.blockNumber());
+   if(it == terminated.constBegin())
+      return -1;
+   --it;
+   return document->findBlockByNumber(*it).position() + blocks.at(*it).ends.last();
+}
+
+int phraseIndex::nextEnd(int pos)
+{
+   QTextBlock block = document->findBlock(pos);
+   if(!block.isValid())
+      return -1;
+   
+   const QVector<int> &ends = blocks.at(block.blockNumber()).ends;
+   for(int i = 0; i < ends.count(); i++)
+   {
+      int end = block.position() + ends.at(i);
+      if(end > pos)
+         return end;
+   }
+   
+   updateTerminated();
+   QVector<int>::const_iterator it = std::upper_bound(terminated.constBegin(), terminated.constEnd(), block.blockNumber());
+   if(it == terminated.constEnd())
+      return -1;
+   return document->findBlockByNumber(*it).position() + blocks.at(*it).ends.first();
+}
+
+void phraseIndex::phraseAt(int pos, int *start, int *end)
+{
+   int length = document->characterCount() - 1; //without the last paragraph separator
+   
+   //at the very end of the text, the phrase is the one that ends there
+   *start = qMax(0, previousEnd(pos, pos >= length));
+   *end = nextEnd(pos);
+   if(*end < 0)
+      *end = length;
+}
@@ -0,0 +1,65 @@
+// phraseindex.h - Where the top-level phrases of a document end
+// This file is part of LemonCaml - Copyright (C) 2012-2014 Corentin FERRY
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PHRASEINDEX_H
+#define PHRASEINDEX_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QTextDocument>
+#include <QTextBlock>
+#include "camllexer.h"
+
+/* Keeps the ";;" that really end a phrase, out of comments and strings,
+ * block by block. Only the edited blocks are scanned again, and the
+ * following ones while the comment or string open at their start changes,
+ * so finding the phrase under the cursor does not read the document. */
+class phraseIndex : public QObject
+{
+   Q_OBJECT
+public:
+   phraseIndex(QTextDocument *document, QObject *parent = 0);
+   
+   //from the end of the ";;" before pos to the end of the one after it
+   void phraseAt(int pos, int *start, int *end);
+   
+   //just past the first ";;" that ends after pos, or -1
+   int nextEnd(int pos);
+   
+private slots:
+   void documentChanged(int from, int charsRemoved, int charsAdded);
+   
+private:
+   struct phraseBlock {
+      int revision;
+      int startState; //what is open at the start, as returned by scan()
+      int endState;
+      QVector<int> ends; //just past each ";;", within the block
+   };
+   
+   int scan(const QString &text, int state, QVector<int> *ends) const;
+   int previousEnd(int pos, bool strict);
+   void updateTerminated();
+   
+   QTextDocument *document;
+   camlLexer lexer; //no keywords needed, only the states
+   QVector<phraseBlock> blocks; //one per block, in block order
+   QVector<int> terminated; //numbers of the blocks holding a ";;", rebuilt when needed
+   bool terminatedDirty;
+};
+
+#endif
@@ -0,0 +1,376 @@
+// searchindex.cpp - Block-wise document search and its trigram index
+// This file is part of LemonCaml - Copyright (C) 2012-2014 Corentin FERRY
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <limits.h>
+#include "searchindex.h"
+#include "common.h"
+
+searchIndex::searchIndex(QTextDocument *document, QObject *parent) : QObject(parent)
+{
+   this->document = document;
+   this->indexed = false;
+}
+
+void searchIndex::setIndexed(bool indexed)
+{
+   if(indexed == this->indexed)
+      return;
+   this->indexed = indexed;
+   
+   if(!indexed)
+   {
+      disconnect(document, SIGNAL(contentsChange(int,int,int)), this, SLOT(documentChanged(int,int,int)));
+      signatures.clear();
+      signatures.squeeze();
+      return;
+   }
+   
+   signatures.resize(document->blockCount());
+   int i = 0;
+   for(QTextBlock block = document->begin(); block.isValid(); block = block.next())
+   {
+      signatures[i].revision = INT_MIN;
+      updateSignature(signatures[i++], block);
+   }
+   connect(document, SIGNAL(contentsChange(int,int,int)), this, SLOT(documentChanged(int,int,int)));
+}
+
+void searchIndex::addTrigrams(const QString &text, quint64 *bits)
+{
+   //case-folded, so that the same signature serves both sensitivities
+   uint a = 0, b = 0;
+   for(int i = 0; i < text.length(); i++)
+   {
+      uint c = text.at(i).toCaseFolded().unicode();
+      if(i >= 2)
+      {
+         uint h = ((a * 961 + b * 31 + c) * 2654435761u) >> 24;
+         bits[h >> 6] |= Q_UINT64_C(1) << (h & 63);
+      }
+      a = b;
+      b = c;
+   }
+}
+
+void searchIndex::updateSignature(blockSignature &sig, const QTextBlock &block)
+{
+   //format changes (e.g. from the highlighter) also come through here, they keep the revision
+   if(sig.revision == block.revision())
+      return;
+   sig.revision = block.revision();
+   for(int i = 0; i < SignatureWords; i++)
+      sig.bits[i] = 0;
+   addTrigrams(block.text(), sig.bits);
+}
+
+void searchIndex::documentChanged(int from, int charsRemoved, int charsAdded)
+{
+   Q_UNUSED(charsRemoved);
+   QTextBlock first = document->findBlock(from);
+   QTextBlock last = document->findBlock(from + charsAdded);
+   if(!first.isValid())
+      first = document->lastBlock();
+   if(!last.isValid())
+      last = document->lastBlock();
+   
+   //the blocks from first to last replace as many blocks, give or take the change in block count
+   int firstNumber = first.blockNumber();
+   int count = last.blockNumber() - firstNumber + 1;
+   int delta = document->blockCount() - signatures.count();
+   if(delta > 0)
+   {
+      blockSignature fresh;
+      fresh.revision = INT_MIN;
+      signatures.insert(firstNumber, delta, fresh);
+   }
+   else if(delta < 0)
+      signatures.remove(firstNumber, -delta);
+   
+   QTextBlock block = first;
+   for(int i = 0; i < count && block.isValid(); i++)
+   {
+      updateSignature(signatures[firstNumber + i], block);
+      block = block.next();
+   }
+}
+
+bool searchIndex::isBlockwise(const QString &pattern, bool regExp)
+{
+   if(pattern.contains('\n') || pattern.contains(QChar::ParagraphSeparator))
+      return false;
+   if(!regExp)
+      return true;
+   
+   //anything that could match a line break ('.' does not, unless asked to with (?s))
+   if(pattern.contains("(?s") || pattern.contains("(?m"))
+      return false;
+   for(int i = 0; i < pattern.length(); i++)
+   {
+      QChar c = pattern.at(i);
+      if(c == '\\' && i + 1 < pattern.length())
+      {
+         QChar e = pattern.at(++i);
+         if(e == 's' || e == 'n' || e == 'W' || e == 'D' || e == 'x' || e == 'o' || e.isDigit() || e == 'c' || e == 'v' || e == 'R' || e == 'H' || e == 'V' || e == 'p' || e == 'P' || e == 'X')
+            return false;
+      }
+      else if(c == '[' && i + 1 < pattern.length() && pattern.at(i + 1) == '^')
+         return false;
+   }
+   return true;
+}
+
+static int escapeEnd(const QString &pattern, int i)
+{
+   //i is on the character after a backslash; returns the last character the escape is made of
+   QChar e = pattern.at(i);
+   int len = pattern.length();
+   if(i + 1 < len && pattern.at(i + 1) == '{' && (e == 'x' || e == 'o' || e == 'u' || e == 'N' || e == 'p' || e == 'P' || e == 'g' || e == 'k'))
+   {
+      //\x{41}, \p{Lu}, \g{-1}...
+      int close = pattern.indexOf('}', i + 1);
+      return (close < 0) ? len - 1 : close;
+   }
+   if(i + 1 < len && e == 'k' && pattern.at(i + 1) == '<')
+   {
+      int close = pattern.indexOf('>', i + 1);
+      return (close < 0) ? len - 1 : close;
+   }
+   
+   int digits = 0;
+   bool hex = false;
+   if(e == 'x' || e == 'u')
+   {
+      digits = (e == 'x') ? 2 : 4;
+      hex = true;
+   }
+   else if(e == '0')
+      digits = 2; //octal
+   else if(e.isDigit())
+      digits = 2; //a backreference, or an octal code
+   else if(e == 'p' || e == 'P' || e == 'c')
+      return qMin(i + 1, len - 1); //\pL, \cA
+   
+   while(digits > 0 && i + 1 < len)
+   {
+      QChar d = pattern.at(i + 1);
+      bool isDigit = hex ? (d.isDigit() || (d.toLower() >= 'a' && d.toLower() <= 'f')) : (e == '0' ? (d >= '0' && d <= '7') : d.isDigit());
+      if(!isDigit)
+         break;
+      i++;
+      digits--;
+   }
+   return i;
+}
+
+QString searchIndex::requiredLiteral(const QString &pattern)
+{
+   //the longest run of plain characters every match must contain
+   if(pattern.contains('|'))
+      return QString();
+   
+   QString best, run;
+   int depth = 0; //groups may be quantified, what they hold is not required
+   bool quantifiable = false; //whether the last character of run is the one a quantifier applies to
+   for(int i = 0; i < pattern.length(); i++)
+   {
+      QChar c = pattern.at(i);
+      bool literal = false;
+      if(c == '(' || c == ')')
+         depth += (c == '(') ? 1 : -1;
+      else if(c == '\\' && i + 1 < pattern.length())
+      {
+         c = pattern.at(++i);
+         literal = !c.isLetterOrNumber() && depth == 0; //\d, \w and such are classes
+         if(!literal)
+            i = escapeEnd(pattern, i); //the digits of \x41 are not literal text either
+      }
+      else if(c == '[')
+      {
+         while(i < pattern.length() && pattern.at(i) != ']')
+            i++;
+      }
+      else if(c == '*' || c == '?' || c == '{')
+      {
+         //the quantified character is optional; a "?" after another quantifier only makes it lazy
+         if(quantifiable)
+            run.chop(1);
+         if(c == '{')
+         {
+            while(i < pattern.length() && pattern.at(i) != '}')
+               i++;
+         }
+      }
+      else
+         literal = c != '.' && c != '^' && c != '$' && c != '+' && c != '}' && c != ']' && c != '\\' && depth == 0;
+      
+      //"b+" still requires one b, but what follows it is not next to it
+      if(literal)
+         run += c;
+      else
+      {
+         if(run.length() > best.length())
+            best = run;
+         run.clear();
+      }
+      quantifiable = literal;
+   }
+   if(run.length() > best.length())
+      best = run;
+   return best;
+}
+
+void searchIndex::prepare(searchQuery *query, const QString &pattern, bool regExp, Qt::CaseSensitivity cs) const
+{
+   query->pattern = pattern;
+   if(regExp)
+      query->re = cachedRegularExpression(pattern, (cs == Qt::CaseSensitive) ? QRegularExpression::NoPatternOption : QRegularExpression::CaseInsensitiveOption);
+   query->regExp = regExp;
+   query->cs = cs;
+   query->blockwise = isBlockwise(pattern, regExp);
+   for(int i = 0; i < SignatureWords; i++)
+      query->bits[i] = 0;
+   if(indexed && query->blockwise)
+      addTrigrams(regExp ? requiredLiteral(pattern) : pattern, query->bits);
+}
+
+int searchIndex::matchInBlock(const searchQuery &query, const QTextBlock &block, int local, bool backward, int *length) const
+{
+   //returns the position of the match in the block, local being where to start from (-1: the end)
+   if(indexed)
+   {
+      const blockSignature &sig = signatures.at(block.blockNumber());
+      for(int i = 0; i < SignatureWords; i++)
+      {
+         if((sig.bits[i] & query.bits[i]) != query.bits[i])
+            return -1;
+      }
+   }
+   
+   QString text = block.text();
+   int blockLength = text.length();
+   if(!query.blockwise)
+   {
+      //the match must start in this block, but may go on in the next ones
+      QTextBlock next = block.next();
+      for(int i = 1; i < SpanBlocks && next.isValid(); i++)
+      {
+         text += '\n' + next.text();
+         next = next.next();
+      }
+   }
+   if(backward && local < 0)
+      local = blockLength;
+   
+   int index;
+   if(!query.regExp)
+   {
+      index = backward ? text.lastIndexOf(query.pattern, local, query.cs) : text.indexOf(query.pattern, qMax(0, local), query.cs);
+      *length = query.pattern.length();
+   }
+   else if(!backward)
+   {
+      QRegularExpressionMatch match = query.re.match(text, qMax(0, local));
+      index = match.hasMatch() ? match.capturedStart() : -1;
+      *length = match.capturedLength();
+   }
+   else
+   {
+      //no backward matching here: the last of the matches starting at or before local
+      index = -1;
+      QRegularExpressionMatchIterator matches = query.re.globalMatch(text);
+      while(matches.hasNext())
+      {
+         QRegularExpressionMatch match = matches.next();
+         if(match.capturedStart() > local)
+            break;
+         index = match.capturedStart();
+         *length = match.capturedLength();
+      }
+   }
+   return (index > blockLength) ? -1 : index; //past the line break, it belongs to the next block
+}
+
+int searchIndex::find(const QString &pattern, bool regExp, Qt::CaseSensitivity cs, int from, bool backward, int *length) const
+{
+   searchQuery query;
+   prepare(&query, pattern, regExp, cs);
+   
+   QTextBlock block = document->findBlock(qMax(0, from));
+   if(!block.isValid())
+      block = document->lastBlock();
+   int local = from - block.position();
+   
+   while(block.isValid())
+   {
+      int index = matchInBlock(query, block, local, backward, length);
+      if(index >= 0)
+         return block.position() + index;
+      block = backward ? block.previous() : block.next();
+      local = backward ? -1 : 0;
+   }
+   return -1;
+}
+
+int searchIndex::findClosest(const QString &pattern, bool regExp, Qt::CaseSensitivity cs, int pos, int *length) const
+{
+   searchQuery query;
+   prepare(&query, pattern, regExp, cs);
+   
+   //walk outward from the cursor, one block each way at a time, until no block can hold a closer match
+   QTextBlock start = document->findBlock(pos);
+   if(!start.isValid())
+      start = document->lastBlock();
+   QTextBlock forward = start;
+   QTextBlock backward = start;
+   int best = -1;
+   int bestDistance = INT_MAX;
+   int len = 0;
+   
+   while(forward.isValid() || backward.isValid())
+   {
+      if(forward.isValid() && forward.position() - pos <= bestDistance)
+      {
+         //a literal may start right before the cursor, as it used to
+         int local = (forward == start) ? pos - forward.position() - (regExp ? 0 : 1) : 0;
+         int index = matchInBlock(query, forward, local, false, &len);
+         if(index >= 0 && forward.position() + index - pos <= bestDistance)
+         {
+            best = forward.position() + index;
+            bestDistance = qAbs(best - pos);
+            *length = len;
+         }
+         forward = forward.next();
+      }
+      else
+         forward = QTextBlock();
+      
+      if(backward.isValid() && pos - (backward.position() + backward.length()) < bestDistance)
+      {
+         int local = (backward == start) ? pos - backward.position() : -1;
+         int index = matchInBlock(query, backward, local, true, &len);
+         if(index >= 0 && pos - (backward.position() + index) < bestDistance)
+         {
+            best = backward.position() + index;
+            bestDistance = pos - best;
+            *length = len;
+         }
+         backward = backward.previous();
+      }
+      else
+         backward = QTextBlock();
+   }
+   return best;
+}
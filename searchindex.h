@@ -0,0 +1,86 @@
+// searchindex.h - Block-wise document search and its trigram index
+// This file is part of LemonCaml - Copyright (C) 2012-2014 Corentin FERRY
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QRegularExpression>
+#include <QTextDocument>
+#include <QTextBlock>
+
+/* Searches a document block by block, reading one block's text at a time
+ * instead of a copy of the whole document, and stopping at the first hit.
+ * 
+ * When indexed, every block also gets a small signature of the trigrams it
+ * contains, updated from contentsChange for the edited blocks only, and
+ * the blocks whose signature lacks a trigram of the pattern are skipped
+ * without reading their text. */
+class searchIndex : public QObject
+{
+   Q_OBJECT
+public:
+   searchIndex(QTextDocument *document, QObject *parent = 0);
+   void setIndexed(bool indexed);
+   
+   //whether the pattern cannot match a line break
+   static bool isBlockwise(const QString &pattern, bool regExp);
+   
+   /* Forward: the first match starting at or after from; backward: the last
+    * one starting at or before from. Returns its position and sets length,
+    * or returns -1. */
+   int find(const QString &pattern, bool regExp, Qt::CaseSensitivity cs, int from, bool backward, int *length) const;
+   
+   //the match closest to pos, either way; the next one wins ties
+   int findClosest(const QString &pattern, bool regExp, Qt::CaseSensitivity cs, int pos, int *length) const;
+   
+private slots:
+   void documentChanged(int from, int charsRemoved, int charsAdded);
+   
+private:
+   enum {
+      SignatureWords = 4, //256 bits per block
+      SpanBlocks = 16 //how many lines a match able to cross line breaks may span
+   };
+   
+   struct blockSignature {
+      int revision;
+      quint64 bits[SignatureWords];
+   };
+   
+   struct searchQuery {
+      QString pattern;
+      QRegularExpression re;
+      bool regExp;
+      bool blockwise;
+      Qt::CaseSensitivity cs;
+      quint64 bits[SignatureWords];
+   };
+   
+   static void addTrigrams(const QString &text, quint64 *bits);
+   static QString requiredLiteral(const QString &pattern);
+   void updateSignature(blockSignature &sig, const QTextBlock &block);
+   void prepare(searchQuery *query, const QString &pattern, bool regExp, Qt::CaseSensitivity cs) const;
+   int matchInBlock(const searchQuery &query, const QTextBlock &block, int local, bool backward, int *length) const;
+   
+   QTextDocument *document;
+   bool indexed;
+   QVector<blockSignature> signatures; //one per block, in block order, when indexed
+};
+
+#endif
@@ -7,12 +7,10 @@ sudo cp ./lemoncaml /usr/bin
 if [ $? == 0 ]; then
    sudo mkdir $DESTDIR
    sudo cp -rf ./caml $DESTDIR
-   sudo cp ./keywords $DESTDIR
    sudo cp ./lemoncaml_*.qm $DESTDIR
    sudo mkdir /etc/xdg/Cocodidou
    echo "[%General]" > ./LemonCaml.conf
    echo "camlPath=$DESTDIR/caml/CamlLightToplevel" >> ./LemonCaml.conf
-   echo "keywordspath=$DESTDIR/keywords" >> ./LemonCaml.conf
    echo "camlArgs= -stdlib \"$DESTDIR/caml/lib\"" >> ./LemonCaml.conf
    echo "treeModelsPath=$DESTDIR/gentree" >> ./LemonCaml.conf
    echo "setupPath=$DESTDIR/" >> ./LemonCaml.conf
@@ -247,7 +247,6 @@ if [ "$INITIALCONFIG" = "true" ]; then
    fi
    echo "[%General]" > ~/.config/Cocodidou/LemonCaml.conf
    echo "camlPath=$(pwd)/caml/CamlLightToplevel" >> ~/.config/Cocodidou/LemonCaml.conf
-   echo "keywordspath=$(pwd)/keywords" >> ~/.config/Cocodidou/LemonCaml.conf
    echo "stdlibPath=$(pwd)/caml/lib" >> ~/.config/Cocodidou/LemonCaml.conf
    echo "treeModelsPath=$(pwd)/gentree" >> ~/.config/Cocodidou/LemonCaml.conf
    echo "Configured LemonCaml."
@@ -0,0 +1,12 @@
+TARGET = tst_common
+
+include(../tests.pri)
+
+SOURCES += tst_common.cpp \
+    ../../common.cpp \
+    ../../camllexer.cpp
+
+HEADERS += \
+    ../../common.h \
+    ../../camllexer.h \
+    ../../keywords_table.h
@@ -0,0 +1,585 @@
+// tst_common.cpp - Golden outputs and benchmarks of the common.cpp text utilities
+// This file is part of LemonCaml - Copyright (C) 2012-2014 Corentin FERRY
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <QtTest>
+#include "common.h"
+#include "testsources.h"
+
+/* The golden outputs are there so that rewriting the utilities for speed
+ * cannot change what they do; the benchmarks run on 1 KB to 10 MB of source. */
+class tst_common : public QObject
+{
+   Q_OBJECT
+   
+private slots:
+   void initTestCase();
+   
+   void stripComments_data();
+   void stripComments();
+   void phraseEnds_data();
+   void phraseEnds();
+   void normalizeOutput_data();
+   void normalizeOutput();
+   void parseCommand_data();
+   void parseCommand();
+   void frameOutput_data();
+   void frameOutput();
+   void frameInterrupted_data();
+   void frameInterrupted();
+   void frameAtPrompt_data();
+   void frameAtPrompt();
+   void frameGentreeCommand_data();
+   void frameGentreeCommand();
+   void removeIndent_data();
+   void removeIndent();
+   void indentCode_data();
+   void indentCode();
+   void indentCodeConcurrently();
+   void indentMatchesRegExpRules_data();
+   void indentMatchesRegExpRules();
+   
+   void benchmarkStripComments_data() { sources(); }
+   void benchmarkStripComments();
+   void benchmarkNormalizeOutput_data() { sources(); }
+   void benchmarkNormalizeOutput();
+   void benchmarkParseCommand_data() { sources(); }
+   void benchmarkParseCommand();
+   void benchmarkRemoveIndent_data() { sources(); }
+   void benchmarkRemoveIndent();
+   void benchmarkIndentCode_data() { sources(); }
+   void benchmarkIndentCode();
+   void benchmarkIndentCodeConcurrently_data() { sources(); }
+   void benchmarkIndentCodeConcurrently();
+   
+private:
+   void sources() { addSourceRows(QList<int>() << 30 << 300 << 3000 << 30000 << 300000); }
+   
+   QVector<indentKeyword> indentWords;
+   QScopedPointer<indentEngine> engine;
+};
+
+static QString describePieces(const QVector<outputFramer::piece> &pieces)
+{
+   //text pieces merged back
+   static const char kinds[] = "TCRcr";
+   QStringList list;
+   QString text;
+   for(int i = 0; i < pieces.count(); i++)
+   {
+      if(pieces.at(i).kind == outputFramer::Text)
+      {
+         text += pieces.at(i).text;
+         continue;
+      }
+      if(!text.isEmpty())
+         list << "T:" + text;
+      text.clear();
+      list << QString(QLatin1Char(kinds[pieces.at(i).kind])) + ":" + pieces.at(i).text;
+   }
+   if(!text.isEmpty())
+      list << "T:" + text;
+   return list.join("|");
+}
+
+static QString framePieces(const QString &stream, int cut)
+{
+   //the stream read in two chunks
+   outputFramer framer;
+   QVector<outputFramer::piece> pieces;
+   framer.feed(stream.left(cut), &pieces);
+   framer.feed(stream.mid(cut), &pieces);
+   return describePieces(pieces);
+}
+
+static QString escapeCommand(const QString &text)
+{
+   //what print_string makes of a command such as the gentree ones
+   QString escaped = text;
+   escaped.replace("\\", "\\\\").replace("\"", "\\\"");
+   return "SendCaml \"" + escaped + "\" SetupPrinter print_int_tree";
+}
+
+void tst_common::initTestCase()
+{
+   fillIndentWords(&indentWords);
+   engine.reset(new indentEngine(indentWords));
+}
+
+void tst_common::stripComments_data()
+{
+   QTest::addColumn<QString>("code");
+   QTest::addColumn<bool>("keepLineBreaks");
+   QTest::addColumn<QString>("expected");
+   
+   QTest::newRow("comment") << "let x = 1 (* one *);;" << false << "let x = 1 ;;";
+   QTest::newRow("separates") << "let(*c*)x" << false << "let x";
+   QTest::newRow("nested") << "a (* x (* y *) z *) b" << false << "a  b";
+   QTest::newRow("string") << "s = \"(* not *)\" (* c *)" << false << "s = \"(* not *)\" ";
+   QTest::newRow("string-inside") << "(* \"*)\" *) x" << false << " x";
+   QTest::newRow("char") << "c = `\"` (* q *)" << false << "c = `\"` ";
+   QTest::newRow("lines") << "a (* 1\n2 *) b" << true << "a \n b";
+}
+
+void tst_common::stripComments()
+{
+   QFETCH(QString, code);
+   QFETCH(bool, keepLineBreaks);
+   QFETCH(QString, expected);
+   QCOMPARE(::stripComments(code, keepLineBreaks), expected);
+}
+
+void tst_common::phraseEnds_data()
+{
+   QTest::addColumn<QString>("code");
+   QTest::addColumn<QString>("expected"); //the line breaks that end a phrase
+   
+   QTest::newRow("lines") << "a;;\nb;;\nc" << "3,7";
+   QTest::newRow("strings-comments") << "let a = 1;;\n\"b;;\n\";;\n(* ;; *)\nc;; (*\n*)" << "11,20";
+}
+
+void tst_common::phraseEnds()
+{
+   QFETCH(QString, code);
+   QFETCH(QString, expected);
+   
+   QVector<int> phraseEnds;
+   ::stripComments(code, true, &phraseEnds);
+   QStringList ends;
+   for(int i = 0; i < phraseEnds.count(); i++)
+      ends << QString::number(phraseEnds.at(i));
+   QCOMPARE(ends.join(","), expected);
+}
+
+void tst_common::normalizeOutput_data()
+{
+   QTest::addColumn<QStringList>("chunks");
+   QTest::addColumn<QString>("expected");
+   
+   QTest::newRow("blank-lines") << (QStringList() << "\n#let x = 1;;  \n\n \nx : int = 1\n") << "#let x = 1;;\nx : int = 1\n";
+   QTest::newRow("chunks") << (QStringList() << "a  " << "\n\nb  c") << "a\nb  c";
+}
+
+void tst_common::normalizeOutput()
+{
+   QFETCH(QStringList, chunks);
+   QFETCH(QString, expected);
+   
+   //as read from the toplevel
+   outputNormalizer normalizer;
+   QByteArray output;
+   for(int i = 0; i < chunks.count(); i++)
+   {
+      QByteArray chunk = chunks.at(i).toLatin1();
+      normalizer.normalize(&chunk);
+      output += chunk;
+   }
+   QCOMPARE(QString(output), expected);
+}
+
+void tst_common::parseCommand_data()
+{
+   QTest::addColumn<QString>("command");
+   QTest::addColumn<QString>("expected"); //the arguments, or the error and where it is
+   
+   QTest::newRow("plain") << "SetupPrinter print_int_tree" << "SetupPrinter|print_int_tree";
+   QTest::newRow("escapes") << "SendCaml \"#open \\\"format\\\";;\nlet x = 1;;\" SetupPrinter p" << "SendCaml|#open \"format\";;\nlet x = 1;;|SetupPrinter|p";
+   QTest::newRow("newline") << "SendCaml \"a\\nbcd\" X" << "SendCaml|a\nbcd|X";
+   QTest::newRow("quotes") << "SendCaml \"let x = \\\"a\\\" in x;;\"  \"\" \\\\" << "SendCaml|let x = \"a\" in x;;||\\";
+   QTest::newRow("unterminated") << "SendCaml \"a b" << "error 1 at 9";
+   QTest::newRow("dangling") << "SendCaml a\\" << "error 2 at 10";
+}
+
+void tst_common::parseCommand()
+{
+   QFETCH(QString, command);
+   QFETCH(QString, expected);
+   
+   blockCommand parsed;
+   QString got;
+   if(parsed.parse(QStringRef(&command)))
+      got = parsed.toStringList().join("|");
+   else
+      got = QString("error %1 at %2").arg(parsed.error()).arg(parsed.errorPosition());
+   QCOMPARE(got, expected);
+}
+
+void tst_common::frameOutput_data()
+{
+   QTest::addColumn<QString>("stream");
+   QTest::addColumn<int>("cut"); //where the stream is split in two reads
+   QTest::addColumn<QString>("expected");
+   
+   QString stream = "a -- b\n--LemonCamlCommand--SetupPrinter p--EndLemonCamlCommand--# --LemonTree--(1)--EndLemonTree--\n";
+   QString whole = "T:a -- b\n|C:SetupPrinter p|T:# |R:(1)|T:\n";
+   for(int cut = 1; cut <= stream.length(); cut++)
+      QTest::newRow(QString("cut-%1").arg(cut).toLatin1().constData()) << stream << cut << whole;
+}
+
+void tst_common::frameOutput()
+{
+   QFETCH(QString, stream);
+   QFETCH(int, cut);
+   QFETCH(QString, expected);
+   QCOMPARE(framePieces(stream, cut), expected);
+}
+
+void tst_common::frameInterrupted_data()
+{
+   QTest::addColumn<QString>("before"); //read before the interruption
+   QTest::addColumn<QString>("after"); //read after it
+   QTest::addColumn<QString>("expected");
+   
+   QTest::newRow("command") << "a --LemonCamlCommand--SendCaml \"x" << "Interrupted.\n#"
+                            << "T:a |c:SendCaml \"x|T:Interrupted.\n#";
+   QTest::newRow("tree") << "--LemonTree--(1, (2" << "--EndLemonTree--\n#"
+                         << "r:(1, (2|T:--EndLemonTree--\n#";
+   QTest::newRow("marker-start") << "a --Lemon" << "Tree--(1)--EndLemonTree--"
+                                 << "T:a --LemonTree--(1)--EndLemonTree--";
+   QTest::newRow("text") << "a -- b" << "c" << "T:a -- bc";
+}
+
+void tst_common::frameInterrupted()
+{
+   QFETCH(QString, before);
+   QFETCH(QString, after);
+   QFETCH(QString, expected);
+   
+   //what is held back comes out at once, and the framer starts over
+   outputFramer framer;
+   QVector<outputFramer::piece> pieces;
+   framer.feed(before, &pieces);
+   framer.flush(&pieces);
+   framer.feed(after, &pieces);
+   framer.flush(&pieces);
+   QCOMPARE(describePieces(pieces), expected);
+}
+
+void tst_common::frameAtPrompt_data()
+{
+   QTest::addColumn<QString>("stream");
+   QTest::addColumn<QString>("expected");
+   
+   QTest::newRow("unterminated") << "--LemonTree--(1, 2\n- : unit = ()\n#" << "r:(1, 2\n- : unit = ()\n#";
+   QTest::newRow("closed") << "--LemonTree--(1)--EndLemonTree--- : unit = ()\n#" << "R:(1)|T:- : unit = ()\n#";
+   QTest::newRow("prompt-like-in-frame") << "--LemonCamlCommand--SendCaml \"\n#open" << "";
+}
+
+void tst_common::frameAtPrompt()
+{
+   QFETCH(QString, stream);
+   QFETCH(QString, expected);
+   
+   //read a character at a time, then the next phrase is sent
+   outputFramer framer;
+   QVector<outputFramer::piece> pieces;
+   for(int i = 0; i < stream.length(); i++)
+      framer.feed(stream.mid(i, 1), &pieces);
+   framer.endAtPrompt(&pieces);
+   QCOMPARE(describePieces(pieces), expected);
+}
+
+static QString gentreeCommand(const QString &program)
+{
+   //what the print_string of a gentree program prints
+   QFile file(QFINDTESTDATA(QString("../../gentree/") + program));
+   if(!file.open(QIODevice::ReadOnly | QIODevice::Text))
+      return QString();
+   QString source = QTextStream(&file).readAll();
+   int start = source.indexOf("print_string \"");
+   if(start < 0)
+      return QString();
+   
+   QString printed;
+   for(int i = start + 14; i < source.length() && source.at(i) != '"'; i++)
+   {
+      if(source.at(i) == '\\' && i + 1 < source.length())
+      {
+         QChar c = source.at(++i);
+         printed += (c == 'n') ? QChar('\n') : c;
+      }
+      else
+         printed += source.at(i);
+   }
+   return printed;
+}
+
+void tst_common::frameGentreeCommand_data()
+{
+   QTest::addColumn<QString>("stream");
+   QTest::addColumn<int>("cut");
+   QTest::addColumn<QString>("expected");
+   
+   static const char *programs[] = { "prodtype.ml", "sumtype.ml" };
+   for(unsigned int i = 0; i < sizeof(programs) / sizeof(programs[0]); i++)
+   {
+      QString command = gentreeCommand(programs[i]);
+      QVERIFY(command.startsWith("--LemonCamlCommand--") && command.endsWith("--EndLemonCamlCommand--"));
+      QVERIFY(command.contains("\n#open"));
+      
+      //the printed command, then the answer of the toplevel and its prompt
+      QString stream = command + "- : unit = ()\n#";
+      QString expected = "C:" + command.mid(20, command.length() - 20 - 23) + "|T:- : unit = ()\n#";
+      for(int cut = 1; cut <= stream.length(); cut++)
+         QTest::newRow(QString("%1-cut-%2").arg(programs[i]).arg(cut).toLatin1().constData()) << stream << cut << expected;
+   }
+}
+
+void tst_common::frameGentreeCommand()
+{
+   QFETCH(QString, stream);
+   QFETCH(int, cut);
+   QFETCH(QString, expected);
+   
+   //the next phrase is sent once everything is read
+   outputFramer framer;
+   QVector<outputFramer::piece> pieces;
+   framer.feed(stream.left(cut), &pieces);
+   framer.feed(stream.mid(cut), &pieces);
+   framer.endAtPrompt(&pieces);
+   QCOMPARE(describePieces(pieces), expected);
+}
+
+void tst_common::removeIndent_data()
+{
+   QTest::addColumn<QString>("code");
+   QTest::addColumn<QString>("expected");
+   
+   QTest::newRow("tabs-spaces") << "\t\tlet x =\n   1;;" << "let x =\n1;;";
+}
+
+void tst_common::removeIndent()
+{
+   QFETCH(QString, code);
+   QFETCH(QString, expected);
+   QCOMPARE(::removeIndent(code), expected);
+}
+
+void tst_common::indentCode_data()
+{
+   QTest::addColumn<QString>("code");
+   QTest::addColumn<bool>("preIndent");
+   QTest::addColumn<QString>("expected");
+   
+   QTest::newRow("let-if") << "let f x =\nif x then\n1\nelse\n2;;\nlet g = (\n3);;" << false
+                           << "let f x =\n\tif x then\n\t1\n\telse\n\t2;;\nlet g = (\n\t3);;";
+   QTest::newRow("decrement") << "let h l =\nmatch l with\n| [] -> 0 (* empty ( *)\n| _ -> begin\n1\nend;;" << false
+                              << "let h l =\n\tmatch l with\n\t| [] -> 0 (* empty ( *)\n\t| _ -> begin\n\t\t1\n\tend;;";
+   QTest::newRow("pre-indent") << "\t\tif a then\nb" << true << "\t\tif a then\n\t\tb";
+}
+
+void tst_common::indentCode()
+{
+   QFETCH(QString, code);
+   QFETCH(bool, preIndent);
+   QFETCH(QString, expected);
+   QCOMPARE(::indentCode(code, engine.data(), preIndent), expected);
+}
+
+void tst_common::indentCodeConcurrently()
+{
+   //large enough to be cut into phrases
+   QString big = ::removeIndent(syntheticSource(30000));
+   QCOMPARE(::indentCodeConcurrently(big, engine.data()), ::indentCode(big, engine.data(), false));
+}
+
+static QString regExpIndentCode(const QString &code)
+{
+   //the indentation as it was computed before the token pass: one QRegExp per rule, run over every line
+   static const char *patterns[] = {
+      "\\blet\\b(.*)=((^((?!and).)*$)(\\band\\b(.*)=))*", "\\btype\\b(.*)=", "\\bin\\b", "\\bwith\\b",
+      "\\(", "\\)", "\\{", "\\}", "\\bbegin\\b", "\\bend\\b", "\\[(\\|?)", "(\\|?)\\]",
+      "\\bfor\\b(.*)\\bdo\\b", "\\bwhile\\b(.*)\\bdo\\b", "\\bdone\\b", "\\btry\\b", "\\bmatch\\b",
+      "\\bif\\b", "\\bthen\\b", "\\band\\b(.*)=", "\\band\\b(.*)=(.*)\\bin\\b", "\\bwhere\\b", ";;"
+   };
+   static const indentRule rules[] = {
+      Increment, Increment, Decrement, Decrement, Increment, Decrement, Increment, Decrement, Increment, Decrement,
+      Increment, Decrement, Increment, Increment, Decrement, Increment, Increment, Increment, Decrement, IDLine,
+      Decrement, IDLine, Reset
+   };
+   static const int ruleCount = sizeof(rules) / sizeof(rules[0]);
+   
+   QStringList separatedLines = code.split('\n', QString::KeepEmptyParts);
+   QStringList treatedLines = ::stripComments(code, true).split('\n', QString::KeepEmptyParts);
+   QStringList result;
+   int indentLevel = 0;
+   for(int k = 0; k < separatedLines.count(); k++)
+   {
+      QString line = treatedLines.at(k);
+      QString ind = QString(indentLevel, '\t') + separatedLines.at(k);
+      int relativeLevel = 0;
+      bool reset = false;
+      bool decrCurrentLine = false;
+      
+      for(int w = 0; w < ruleCount; w++)
+      {
+         QRegExp expression(patterns[w]);
+         int index = expression.indexIn(line);
+         while(index >= 0)
+         {
+            switch(rules[w])
+            {
+               case Increment:
+                  relativeLevel += 1;
+                  break;
+               case IDLine:
+                  relativeLevel += (index == 0) ? 0 : 1;
+                  decrCurrentLine = decrCurrentLine || index == 0;
+                  break;
+               case Decrement:
+                  relativeLevel -= 1;
+                  decrCurrentLine = decrCurrentLine || index == 0;
+                  break;
+               case Reset:
+                  relativeLevel = 0;
+                  reset = true;
+                  while(index == 0 && ind.startsWith('\t'))
+                     ind.remove(0, 1);
+                  break;
+            }
+            index = expression.indexIn(line, index + expression.matchedLength());
+         }
+      }
+      
+      relativeLevel = qBound(-1, relativeLevel, 1);
+      indentLevel = reset ? 0 : indentLevel + relativeLevel;
+      if(decrCurrentLine && ind.startsWith('\t'))
+         ind.remove(0, 1);
+      result << ind;
+   }
+   return result.join("\n");
+}
+
+static QString randomLines(uint seed, int lines)
+{
+   //keywords and symbols glued or spaced at random, accented words and words containing keywords included
+   static const char *tokens[] = {
+      "let", "type", "in", "with", "(", ")", "{", "}", "begin", "end", "[", "[|", "|]", "]", "|", "for", "while",
+      "do", "done", "try", "match", "if", "then", "else", "and", "where", ";;", ";", "=", "==", "->", "x", "f_2",
+      "let_", "_in", "letx", "in2", "\xc3\xa9t\xc3\xa9", "\xc3\xa0let", "let\xc3\xa0", "end\xc3\xa9", "(* c *)", "\"s;; (\"", "`(`"
+   };
+   static const int tokenCount = sizeof(tokens) / sizeof(tokens[0]);
+   
+   QStringList result;
+   for(int k = 0; k < lines; k++)
+   {
+      QString line;
+      int words = (seed >> 16) % 8;
+      for(int i = 0; i < words; i++)
+      {
+         seed = seed * 1103515245u + 12345u;
+         line += QString::fromUtf8(tokens[(seed >> 16) % tokenCount]);
+         if((seed >> 8) % 3 != 0)
+            line += ' ';
+      }
+      seed = seed * 1103515245u + 12345u;
+      result << line;
+   }
+   return result.join("\n");
+}
+
+void tst_common::indentMatchesRegExpRules_data()
+{
+   QTest::addColumn<QString>("code");
+   
+   QTest::newRow("synthetic") << ::removeIndent(syntheticSource(300));
+   static const char *programs[] = { "prodtype.ml", "sumtype.ml" };
+   for(unsigned int i = 0; i < sizeof(programs) / sizeof(programs[0]); i++)
+   {
+      QFile file(QFINDTESTDATA(QString("../../gentree/") + programs[i]));
+      QVERIFY(file.open(QIODevice::ReadOnly | QIODevice::Text));
+      QTest::newRow(programs[i]) << ::removeIndent(QTextStream(&file).readAll());
+   }
+   for(uint seed = 1; seed <= 20; seed++)
+      QTest::newRow(QString("random-%1").arg(seed).toLatin1().constData()) << randomLines(seed, 200);
+}
+
+void tst_common::indentMatchesRegExpRules()
+{
+   QFETCH(QString, code);
+   
+   //line by line, so that a failure shows the first line that differs
+   QStringList expected = regExpIndentCode(code).split('\n');
+   QStringList got = ::indentCode(code, engine.data(), false).split('\n');
+   QCOMPARE(got.count(), expected.count());
+   for(int i = 0; i < got.count(); i++)
+   {
+      if(got.at(i) != expected.at(i))
+         QCOMPARE(QString("%1: %2").arg(i + 1).arg(got.at(i)), QString("%1: %2").arg(i + 1).arg(expected.at(i)));
+   }
+}
+
+void tst_common::benchmarkStripComments()
+{
+   QFETCH(QString, text);
+   QBENCHMARK {
+      ::stripComments(text, false);
+   }
+}
+
+void tst_common::benchmarkNormalizeOutput()
+{
+   QFETCH(QString, text);
+   
+   //as read from the toplevel, a pipe buffer at a time
+   QByteArray output = text.toLatin1();
+   QBENCHMARK {
+      outputNormalizer normalizer;
+      for(int pos = 0; pos < output.length(); pos += 4096)
+      {
+         QByteArray chunk = output.mid(pos, 4096);
+         normalizer.normalize(&chunk);
+      }
+   }
+}
+
+void tst_common::benchmarkParseCommand()
+{
+   QFETCH(QString, text);
+   QString command = escapeCommand(text);
+   QBENCHMARK {
+      blockCommand parsed;
+      parsed.parse(QStringRef(&command));
+   }
+}
+
+void tst_common::benchmarkRemoveIndent()
+{
+   QFETCH(QString, text);
+   QBENCHMARK {
+      ::removeIndent(text);
+   }
+}
+
+void tst_common::benchmarkIndentCode()
+{
+   QFETCH(QString, text);
+   QString unindented = ::removeIndent(text);
+   QBENCHMARK {
+      ::indentCode(unindented, engine.data(), false);
+   }
+}
+
+void tst_common::benchmarkIndentCodeConcurrently()
+{
+   QFETCH(QString, text);
+   QString unindented = ::removeIndent(text);
+   QBENCHMARK {
+      ::indentCodeConcurrently(unindented, engine.data());
+   }
+}
+
+QTEST_MAIN(tst_common)
+#include "tst_common.moc"
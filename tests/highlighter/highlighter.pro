@@ -0,0 +1,14 @@
+TARGET = tst_highlighter
+
+include(../tests.pri)
+
+SOURCES += tst_highlighter.cpp \
+    ../../highlighter.cpp \
+    ../../camllexer.cpp \
+    ../../common.cpp
+
+HEADERS += \
+    ../../highlighter.h \
+    ../../camllexer.h \
+    ../../common.h \
+    ../../keywords_table.h
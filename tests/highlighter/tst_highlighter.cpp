@@ -0,0 +1,300 @@
+// tst_highlighter.cpp - Tests and benchmarks of the lexer and the highlighter
+// This file is part of LemonCaml - Copyright (C) 2012-2014 Corentin FERRY
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <QtTest>
+#include <QTextDocument>
+#include <QTextCursor>
+#include <QTextBlock>
+#include "highlighter.h"
+#include "camllexer.h"
+#include "testsources.h"
+
+/* No editor is attached to the highlighters below, so they format the
+ * whole document synchronously, and an edit is highlighted as it happens. */
+class tst_highlighter : public QObject
+{
+   Q_OBJECT
+   
+public:
+   tst_highlighter() : settings("Cocodidou", "LemonCamlTests") {}
+   
+private slots:
+   void builtinKeywords_data();
+   void builtinKeywords();
+   void states_data();
+   void states();
+   void definitions();
+   
+   void lex_data() { sources(); }
+   void lex();
+   void full_data() { sources(); }
+   void full();
+   void editMiddle_data() { sources(); }
+   void editMiddle();
+   void openCommentTop_data() { sources(); }
+   void openCommentTop();
+   void themeChange_data() { sources(); }
+   void themeChange();
+   
+private:
+   static int commentState(int depth, bool stringInComment = false);
+   static highlightData *dataOf(QTextDocument *doc, int number);
+   static void replaceBlock(QTextDocument *doc, int number, const QString &text);
+   static void removeBlock(QTextDocument *doc, int number);
+   void sources() { addSourceRows(QList<int>() << 1000 << 10000 << 100000); }
+   
+   QSettings settings; //no user settings, the default colors
+   QStringList noKeywords; //the built-in table only
+};
+
+void tst_highlighter::builtinKeywords_data()
+{
+   QTest::addColumn<QString>("word");
+   QTest::addColumn<int>("construct");
+   
+   //read as genkeywords.awk does: the last construct given to a word wins, an empty line ends the list
+   QFile file(QFINDTESTDATA("../../keywords"));
+   QVERIFY(file.open(QIODevice::ReadOnly | QIODevice::Text));
+   QTextStream in(&file);
+   QStringList words;
+   QHash<QString, int> constructs;
+   for(QString line = in.readLine(); !line.isEmpty(); line = in.readLine())
+   {
+      QStringList spl = line.split(';');
+      if(line.startsWith('#') || spl.count() != 2 || spl[0].isEmpty() || spl[1].isEmpty())
+         continue;
+      if(!constructs.contains(spl[0]))
+         words << spl[0];
+      constructs.insert(spl[0], spl[1].toInt());
+   }
+   QVERIFY(!words.isEmpty());
+   
+   for(int i = 0; i < words.count(); i++)
+      QTest::newRow(words[i].toLatin1().constData()) << words[i] << constructs.value(words[i]);
+}
+
+void tst_highlighter::builtinKeywords()
+{
+   QFETCH(QString, word);
+   QFETCH(int, construct);
+   
+   //keywords_table.h is generated from the keywords file: a stale table shows here
+   camlLexer lexer;
+   QVector<camlToken> tokens;
+   lexer.lex(word, camlLexer::NormalState, &tokens);
+   QCOMPARE(tokens.count(), 1);
+   QCOMPARE(tokens.at(0).start, 0);
+   QCOMPARE(tokens.at(0).length, word.length());
+   QCOMPARE(tokens.at(0).construct, construct);
+}
+
+int tst_highlighter::commentState(int depth, bool stringInComment)
+{
+   return camlLexer::InComment | (stringInComment ? camlLexer::StringInComment : 0) | (depth << camlLexer::DepthShift);
+}
+
+void tst_highlighter::states_data()
+{
+   QTest::addColumn<QString>("text");
+   QTest::addColumn<QList<int> >("states"); //at the end of each block
+   
+   int normal = camlLexer::NormalState;
+   int string = camlLexer::InString;
+   QTest::newRow("comment") << "a (* b\nc *) d" << (QList<int>() << commentState(1) << normal);
+   QTest::newRow("nested-comment") << "a (* b (* c\nd *) e\nf *) g\nh" << (QList<int>() << commentState(2) << commentState(1) << normal << normal);
+   QTest::newRow("nested-comment-lines") << "(*(*(*\n*)\n(*\n*)*)*)" << (QList<int>() << commentState(3) << commentState(2) << commentState(3) << normal);
+   QTest::newRow("string-in-comment") << "(* \"*)\n*)\" *)\nx" << (QList<int>() << commentState(1, true) << normal << normal);
+   QTest::newRow("string-in-nested-comment") << "(* (* \"*) *)\" *)\n*)" << (QList<int>() << commentState(1) << normal);
+   QTest::newRow("escaped-quote-in-comment") << "(* \"\\\"*)\n\" *)" << (QList<int>() << commentState(1, true) << normal);
+   QTest::newRow("comment-in-string") << "\"(*\n\" x" << (QList<int>() << string << normal);
+   QTest::newRow("char-quote") << "f `\"` (*\n*)" << (QList<int>() << commentState(1) << normal);
+   QTest::newRow("char-escaped-quote") << "f `\\\"` \"\ng\"" << (QList<int>() << string << normal);
+   QTest::newRow("lone-backquote") << "f ` \"\ng\"" << (QList<int>() << string << normal);
+}
+
+void tst_highlighter::states()
+{
+   QFETCH(QString, text);
+   QFETCH(QList<int>, states);
+   QTextDocument doc;
+   doc.setPlainText(text);
+   QCOMPARE(doc.blockCount(), states.count());
+   
+   //the lexer alone, then what the highlighter stores in the blocks
+   camlLexer lexer;
+   int state = camlLexer::NormalState;
+   int i = 0;
+   for(QTextBlock block = doc.begin(); block.isValid(); block = block.next(), i++)
+   {
+      state = lexer.lex(block.text(), state, NULL);
+      QCOMPARE(state, states.at(i));
+   }
+   
+   highlighter hl(&doc, &noKeywords, &settings);
+   hl.rehighlight();
+   i = 0;
+   for(QTextBlock block = doc.begin(); block.isValid(); block = block.next(), i++)
+      QCOMPARE(block.userState(), states.at(i));
+}
+
+highlightData *tst_highlighter::dataOf(QTextDocument *doc, int number)
+{
+   return static_cast<highlightData*>(doc->findBlockByNumber(number).userData());
+}
+
+void tst_highlighter::replaceBlock(QTextDocument *doc, int number, const QString &text)
+{
+   QTextCursor cursor(doc->findBlockByNumber(number));
+   cursor.movePosition(QTextCursor::EndOfBlock, QTextCursor::KeepAnchor);
+   cursor.insertText(text);
+}
+
+void tst_highlighter::removeBlock(QTextDocument *doc, int number)
+{
+   QTextCursor cursor(doc->findBlockByNumber(number));
+   cursor.movePosition(QTextCursor::NextBlock, QTextCursor::KeepAnchor);
+   cursor.removeSelectedText();
+}
+
+void tst_highlighter::definitions()
+{
+   QTextDocument doc;
+   doc.setPlainText("let f x = x;;\n"
+                    "let g y =\n"
+                    "  let h = f y and k = 1 in\n"
+                    "  h + k;;\n"
+                    "type t = A | B;;\n"
+                    "let z = A;;\n"
+                    "let f = 2;;");
+   highlighter hl(&doc, &noKeywords, &settings);
+   hl.rehighlight();
+   QSharedPointer<definitionIndex> index = dataOf(&doc, 0)->index;
+   QVERIFY(!index.isNull());
+   
+   //top-level declarations only: the local "let ... and ... in" binds nothing
+   QCOMPARE(index->constructFor("f"), (int)highlighter::UserFunction);
+   QCOMPARE(index->constructFor("g"), (int)highlighter::UserFunction);
+   QCOMPARE(index->constructFor("h"), -1);
+   QCOMPARE(index->constructFor("k"), -1);
+   QCOMPARE(index->constructFor("t"), (int)highlighter::UserType);
+   QCOMPARE(index->constructFor("A"), (int)highlighter::UserConstructor);
+   QCOMPARE(index->constructFor("z"), (int)highlighter::UserFunction);
+   QCOMPARE(index->usersOf("f"), QSet<highlightData*>() << dataOf(&doc, 2));
+   QCOMPARE(index->usersOf("h"), QSet<highlightData*>() << dataOf(&doc, 2) << dataOf(&doc, 3));
+   QCOMPARE(index->usersOf("A"), QSet<highlightData*>() << dataOf(&doc, 5));
+   
+   //renaming one of the two declarations of f leaves it declared
+   replaceBlock(&doc, 0, "let ff x = x;;");
+   QCOMPARE(index->constructFor("f"), (int)highlighter::UserFunction);
+   QCOMPARE(index->constructFor("ff"), (int)highlighter::UserFunction);
+   QCOMPARE(index->usersOf("x"), QSet<highlightData*>() << dataOf(&doc, 0));
+   
+   //a using block changes what it uses
+   replaceBlock(&doc, 5, "let z = B;;");
+   QVERIFY(index->usersOf("A").isEmpty());
+   QCOMPARE(index->usersOf("B"), QSet<highlightData*>() << dataOf(&doc, 5));
+   
+   //a deleted using block takes its uses along
+   removeBlock(&doc, 2);
+   QVERIFY(index->usersOf("f").isEmpty());
+   QCOMPARE(index->usersOf("h"), QSet<highlightData*>() << dataOf(&doc, 2));
+   QCOMPARE(index->usersOf("y"), QSet<highlightData*>() << dataOf(&doc, 1));
+   
+   //and a deleted declaring block its declarations
+   removeBlock(&doc, 3);
+   QCOMPARE(index->constructFor("t"), -1);
+   QCOMPARE(index->constructFor("A"), -1);
+   QCOMPARE(index->constructFor("B"), -1);
+   QCOMPARE(index->usersOf("B"), QSet<highlightData*>() << dataOf(&doc, 3));
+   replaceBlock(&doc, 4, "");
+   QCOMPARE(index->constructFor("f"), -1);
+   QCOMPARE(index->constructFor("ff"), (int)highlighter::UserFunction);
+}
+
+void tst_highlighter::lex()
+{
+   QFETCH(QString, text);
+   QTextDocument doc;
+   doc.setPlainText(text);
+   
+   //lexing alone, state and tokens, with no formatting
+   camlLexer lexer;
+   QVector<camlToken> tokens;
+   QBENCHMARK {
+      int state = camlLexer::NormalState;
+      for(QTextBlock block = doc.begin(); block.isValid(); block = block.next())
+         state = lexer.lex(block.text(), state, &tokens);
+   }
+}
+
+void tst_highlighter::full()
+{
+   QFETCH(QString, text);
+   QTextDocument doc;
+   doc.setPlainText(text);
+   highlighter hl(&doc, &noKeywords, &settings);
+   
+   QBENCHMARK {
+      hl.rehighlight();
+   }
+}
+
+void tst_highlighter::editMiddle()
+{
+   QFETCH(QString, text);
+   QTextDocument doc;
+   doc.setPlainText(text);
+   highlighter hl(&doc, &noKeywords, &settings);
+   hl.rehighlight(); //the first highlight is delayed to the event loop, which does not run here
+   
+   QTextCursor cursor(doc.findBlockByNumber(doc.blockCount() / 2));
+   QBENCHMARK {
+      cursor.insertText("x");
+   }
+}
+
+void tst_highlighter::openCommentTop()
+{
+   QFETCH(QString, text);
+   QTextDocument doc;
+   doc.setPlainText(text);
+   highlighter hl(&doc, &noKeywords, &settings);
+   hl.rehighlight();
+   
+   //every block after the "(*" changes state; once, since a second one would only nest deeper
+   QTextCursor cursor(&doc);
+   QBENCHMARK_ONCE {
+      cursor.insertText("(*");
+   }
+}
+
+void tst_highlighter::themeChange()
+{
+   QFETCH(QString, text);
+   QTextDocument doc;
+   doc.setPlainText(text);
+   highlighter hl(&doc, &noKeywords, &settings);
+   
+   //search results are extra selections, a theme change is what still rehighlights
+   highlighter::Theme theme = hl.theme();
+   QBENCHMARK {
+      theme.formats[highlighter::Comment].setFontUnderline(!theme.formats[highlighter::Comment].fontUnderline());
+      hl.setTheme(theme);
+   }
+}
+
+QTEST_MAIN(tst_highlighter)
+#include "tst_highlighter.moc"
@@ -0,0 +1,12 @@
+TARGET = tst_phraseindex
+
+include(../tests.pri)
+
+SOURCES += tst_phraseindex.cpp \
+    ../../phraseindex.cpp \
+    ../../camllexer.cpp
+
+HEADERS += \
+    ../../phraseindex.h \
+    ../../camllexer.h \
+    ../../keywords_table.h
@@ -0,0 +1,106 @@
+// tst_phraseindex.cpp - Tests of the index of phrase ends
+// This file is part of LemonCaml - Copyright (C) 2012-2014 Corentin FERRY
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <QtTest>
+#include <QTextDocument>
+#include <QTextCursor>
+#include "phraseindex.h"
+
+/* The index is only updated from the edited blocks on, so after any edit
+ * it must find the same phrases as an index built from the whole text. */
+class tst_phraseindex : public QObject
+{
+   Q_OBJECT
+   
+private slots:
+   void edit_data();
+   void edit();
+   
+private:
+   static QList<int> ends(phraseIndex *index);
+};
+
+QList<int> tst_phraseindex::ends(phraseIndex *index)
+{
+   QList<int> result;
+   for(int end = index->nextEnd(0); end >= 0; end = index->nextEnd(end))
+      result << end;
+   return result;
+}
+
+void tst_phraseindex::edit_data()
+{
+   QTest::addColumn<QString>("text");
+   QTest::addColumn<int>("position");
+   QTest::addColumn<int>("removed");
+   QTest::addColumn<QString>("inserted");
+   QTest::addColumn<QList<int> >("expected"); //just past each ";;" once edited
+   
+   QString text = "let a = 1;;\nlet b = 2;;\nlet c = 3;;";
+   QTest::newRow("unchanged") << text << 0 << 0 << "" << (QList<int>() << 11 << 23 << 35);
+   QTest::newRow("insert-end") << text << 5 << 0 << ";;" << (QList<int>() << 7 << 13 << 25 << 37);
+   QTest::newRow("delete-end") << text << 9 << 2 << "" << (QList<int>() << 21 << 33);
+   QTest::newRow("split-end") << text << 10 << 0 << "\n" << (QList<int>() << 24 << 36);
+   QTest::newRow("merge-lines") << text << 11 << 1 << "" << (QList<int>() << 11 << 22 << 34);
+   QTest::newRow("open-comment") << text << 0 << 0 << "(*" << QList<int>();
+   QTest::newRow("open-nested-comment") << "(* a *)\nb;;\nc;;" << 3 << 0 << "(*" << QList<int>();
+   QTest::newRow("close-comment") << text << 16 << 0 << "(*" << (QList<int>() << 11);
+   QTest::newRow("delete-comment") << "(* a;;\nb;; *)\nlet c = 3;;" << 0 << 2 << "" << (QList<int>() << 4 << 8 << 23);
+   QTest::newRow("open-string") << text << 4 << 0 << "\"" << QList<int>();
+   QTest::newRow("close-string") << "let s = \"a;;\nb;;\nc;;" << 16 << 0 << "\"" << (QList<int>() << 20);
+   QTest::newRow("string-in-comment") << text << 0 << 0 << "(* \"*)\" *)" << (QList<int>() << 21 << 33 << 45);
+   QTest::newRow("open-string-in-comment") << "(* \"*)\" *) a;;\nb;;" << 3 << 1 << "" << QList<int>();
+   QTest::newRow("char-literal") << "let c = `;`;;\nd;;" << 9 << 1 << "\"" << (QList<int>() << 13 << 17);
+   QTest::newRow("char-literal-removed") << "let c = `;`;;\nd;;" << 8 << 1 << "" << (QList<int>() << 12 << 16);
+}
+
+void tst_phraseindex::edit()
+{
+   QFETCH(QString, text);
+   QFETCH(int, position);
+   QFETCH(int, removed);
+   QFETCH(QString, inserted);
+   QFETCH(QList<int>, expected);
+   
+   QTextDocument doc;
+   doc.setPlainText(text);
+   phraseIndex index(&doc);
+   
+   //as typed, one character at a time
+   QTextCursor cursor(&doc);
+   cursor.setPosition(position);
+   for(int i = 0; i < removed; i++)
+      cursor.deleteChar();
+   for(int i = 0; i < inserted.length(); i++)
+      cursor.insertText(inserted.at(i));
+   
+   QCOMPARE(ends(&index), expected);
+   
+   QTextDocument fresh;
+   fresh.setPlainText(doc.toPlainText());
+   phraseIndex reference(&fresh);
+   for(int pos = 0; pos < doc.characterCount(); pos++)
+   {
+      int start, end, freshStart, freshEnd;
+      index.phraseAt(pos, &start, &end);
+      reference.phraseAt(pos, &freshStart, &freshEnd);
+      QCOMPARE(start, freshStart);
+      QCOMPARE(end, freshEnd);
+   }
+}
+
+QTEST_MAIN(tst_phraseindex)
+#include "tst_phraseindex.moc"
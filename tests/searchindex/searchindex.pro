@@ -0,0 +1,14 @@
+TARGET = tst_searchindex
+
+include(../tests.pri)
+
+SOURCES += tst_searchindex.cpp \
+    ../../searchindex.cpp \
+    ../../common.cpp \
+    ../../camllexer.cpp
+
+HEADERS += \
+    ../../searchindex.h \
+    ../../common.h \
+    ../../camllexer.h \
+    ../../keywords_table.h
@@ -0,0 +1,163 @@
+// tst_searchindex.cpp - Tests of the trigram search index
+// This file is part of LemonCaml - Copyright (C) 2012-2014 Corentin FERRY
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <QtTest>
+#include <QTextDocument>
+#include <QTextCursor>
+#include "searchindex.h"
+
+/* The index only skips blocks, it must never change what is found: every
+ * search gives the same result with the index as without it. */
+class tst_searchindex : public QObject
+{
+   Q_OBJECT
+   
+private slots:
+   void find_data();
+   void find();
+   void edit_data();
+   void edit();
+};
+
+void tst_searchindex::find_data()
+{
+   QTest::addColumn<QString>("text");
+   QTest::addColumn<QString>("pattern");
+   QTest::addColumn<bool>("regExp");
+   QTest::addColumn<int>("position");
+   QTest::addColumn<int>("length");
+   
+   QTest::newRow("plain") << "x\nlet y" << "et" << false << 3 << 2;
+   QTest::newRow("plain-missing") << "x\nlet y" << "ets" << false << -1 << 0;
+   QTest::newRow("dot") << "x\nlet y" << "l.t" << true << 2 << 3;
+   QTest::newRow("escaped-dot") << "x\nl.t y" << "l\\.t" << true << 2 << 3;
+   QTest::newRow("plus") << "x\nabbc" << "ab+c" << true << 2 << 4;
+   QTest::newRow("star") << "x\nac" << "ab*c" << true << 2 << 2;
+   QTest::newRow("lazy") << "x\nac" << "ab*?c" << true << 2 << 2;
+   QTest::newRow("braces") << "x\nabbbc" << "ab{2,3}c" << true << 2 << 5;
+   QTest::newRow("class") << "x\nlet y" << "l[aeiou]t" << true << 2 << 3;
+   QTest::newRow("group") << "x\nlet y" << "(le)+t" << true << 2 << 3;
+   QTest::newRow("regexp-missing") << "x\nlet y" << "l.x" << true << -1 << 0;
+   QTest::newRow("hex") << "x\nAbc" << "\\x41bc" << true << 2 << 3;
+   QTest::newRow("hex-braces") << "x\nAbc" << "\\x{41}bc" << true << 2 << 3;
+   QTest::newRow("octal") << "x\n\tbc" << "\\011bc" << true << 2 << 3;
+   QTest::newRow("property") << "x\nAbc" << "\\pLbc" << true << 2 << 3;
+   QTest::newRow("property-braces") << "x\nAbc" << "\\p{Lu}bc" << true << 2 << 3;
+   QTest::newRow("backreference") << "x\nabab" << "(ab)\\1" << true << 2 << 4;
+   QTest::newRow("named-backreference") << "x\nabab" << "(?<p>ab)\\k<p>" << true << 2 << 4;
+   QTest::newRow("non-newline") << "x\nabbc" << "a\\N{2}c" << true << 2 << 4;
+}
+
+void tst_searchindex::find()
+{
+   QFETCH(QString, text);
+   QFETCH(QString, pattern);
+   QFETCH(bool, regExp);
+   QFETCH(int, position);
+   QFETCH(int, length);
+   
+   QTextDocument doc;
+   doc.setPlainText(text);
+   searchIndex index(&doc);
+   
+   for(int indexed = 0; indexed < 2; indexed++)
+   {
+      index.setIndexed(indexed == 1);
+      int found = 0;
+      QCOMPARE(index.find(pattern, regExp, Qt::CaseSensitive, 0, false, &found), position);
+      if(position >= 0)
+         QCOMPARE(found, length);
+   }
+}
+
+void tst_searchindex::edit_data()
+{
+   QTest::addColumn<QString>("text");
+   QTest::addColumn<int>("position");
+   QTest::addColumn<int>("removed");
+   QTest::addColumn<QString>("inserted");
+   QTest::addColumn<bool>("typed"); //one character at a time, or pasted at once
+   QTest::addColumn<QString>("pattern");
+   QTest::addColumn<bool>("regExp");
+   
+   QString text = "let foo = 1\nlet bar = foo\n\nfoo bar";
+   QTest::newRow("typing") << text << 26 << 0 << "barfoo" << true << "barfoo" << false;
+   QTest::newRow("typing-regexp") << text << 26 << 0 << "barfoo" << true << "r+fo" << true;
+   QTest::newRow("deleting") << text << 4 << 3 << "" << true << "foo" << false;
+   QTest::newRow("split") << text << 6 << 0 << "\n" << true << "foo" << false;
+   QTest::newRow("split-regexp") << text << 6 << 0 << "\n" << true << "f.o" << true;
+   QTest::newRow("merge") << text << 11 << 1 << "" << true << "1let" << false;
+   QTest::newRow("merge-regexp") << text << 11 << 1 << "" << true << "1l+et" << true;
+   QTest::newRow("merge-several") << text << 8 << 20 << "" << true << "= foo" << false;
+   QTest::newRow("paste") << text << 12 << 0 << "foo\nbarfoo\n" << false << "barfoo" << false;
+   QTest::newRow("paste-replacing") << text << 4 << 20 << "baz\nfoo" << false << "foo" << false;
+}
+
+void tst_searchindex::edit()
+{
+   QFETCH(QString, text);
+   QFETCH(int, position);
+   QFETCH(int, removed);
+   QFETCH(QString, inserted);
+   QFETCH(bool, typed);
+   QFETCH(QString, pattern);
+   QFETCH(bool, regExp);
+   
+   //the index follows the edits from contentsChange, the plain search reads the blocks as they are
+   QTextDocument doc;
+   doc.setPlainText(text);
+   searchIndex index(&doc);
+   index.setIndexed(true);
+   searchIndex plain(&doc);
+   
+   QTextCursor cursor(&doc);
+   cursor.setPosition(position);
+   cursor.setPosition(position + removed, QTextCursor::KeepAnchor);
+   cursor.removeSelectedText();
+   if(typed)
+   {
+      for(int i = 0; i < inserted.length(); i++)
+         cursor.insertText(inserted.at(i));
+   }
+   else
+      cursor.insertText(inserted);
+   
+   int end = doc.characterCount() - 1;
+   for(int from = 0; from <= end; from++)
+   {
+      for(int backward = 0; backward < 2; backward++)
+      {
+         int length = 0, plainLength = 0;
+         int found = index.find(pattern, regExp, Qt::CaseSensitive, from, backward == 1, &length);
+         QCOMPARE(found, plain.find(pattern, regExp, Qt::CaseSensitive, from, backward == 1, &plainLength));
+         if(found >= 0)
+            QCOMPARE(length, plainLength);
+      }
+      
+      int length = 0, plainLength = 0;
+      int found = index.findClosest(pattern, regExp, Qt::CaseSensitive, from, &length);
+      QCOMPARE(found, plain.findClosest(pattern, regExp, Qt::CaseSensitive, from, &plainLength));
+      if(found >= 0)
+         QCOMPARE(length, plainLength);
+   }
+   
+   //and the edit did change what there is to find
+   int length = 0;
+   QCOMPARE(index.find(pattern, regExp, Qt::CaseSensitive, 0, false, &length) >= 0, doc.toPlainText().contains(QRegularExpression(regExp ? pattern : QRegularExpression::escape(pattern))));
+}
+
+QTEST_MAIN(tst_searchindex)
+#include "tst_searchindex.moc"
@@ -0,0 +1,16 @@
+# Settings shared by every test; a test lists the LemonCaml sources it needs
+
+QT       += core \
+    widgets \
+    concurrent \
+    testlib
+
+CONFIG += c++11 \
+    testcase \
+    no_testcase_installs
+
+INCLUDEPATH += $$PWD/..
+
+SOURCES += $$PWD/testsources.cpp
+
+HEADERS += $$PWD/testsources.h
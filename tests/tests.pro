@@ -0,0 +1,10 @@
+# The unit tests and benchmarks of LemonCaml, run by "make check".
+# Each test takes the usual QtTest options; "-csv" prints the benchmark
+# results in a form that can be compared between versions.
+
+TEMPLATE = subdirs
+
+SUBDIRS = highlighter \
+    common \
+    searchindex \
+    phraseindex
@@ -0,0 +1,87 @@
+// testsources.cpp - Caml sources the tests and benchmarks run on
+// This file is part of LemonCaml - Copyright (C) 2012-2014 Corentin FERRY
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <QtTest>
+#include <QFile>
+#include <QTextStream>
+#include "testsources.h"
+
+QString syntheticSource(int lines)
+{
+   //a bit of everything the lexer knows about, in the proportions of a typical program
+   static const char *pattern[] = {
+      "(* computes the sum of a list of integers *)",
+      "let rec sum l = match l with",
+      "   | [] -> 0",
+      "   | t::q -> t + sum q;;",
+      "",
+      "let is_vowel c = c = `a` || c = `e` || c = `\\n`;;",
+      "let greet name = print_string (\"Hello, \" ^ name ^ \"!\\n\");;",
+      "(* nested (* comments *) and a \"*) string\" inside *)",
+      "let count v = let n = ref 0 in",
+      "   for i = 0 to vect_length v - 1 do",
+      "      if v.(i) > 0 then n := !n + 1",
+      "   done; !n;;",
+      "type tree = Leaf | Node of tree * int * tree;;",
+      "while true do print_int 42 done;;"
+   };
+   static const int patternLines = sizeof(pattern) / sizeof(pattern[0]);
+   
+   QStringList src;
+   for(int i = 0; i < lines; i++)
+      src << QString::fromLatin1(pattern[i % patternLines]);
+   return src.join("\n");
+}
+
+QString resizeSource(const QString &text, int lines)
+{
+   QStringList original = text.split('\n');
+   QStringList src;
+   for(int i = 0; i < lines; i++)
+      src << original.at(i % original.count());
+   return src.join("\n");
+}
+
+void addSourceRows(const QList<int> &sizes)
+{
+   QTest::addColumn<QString>("text");
+   
+   QStringList names;
+   QStringList sources;
+   names << "synthetic";
+   sources << QString();
+   
+   static const char *programs[] = { "prodtype.ml", "sumtype.ml" };
+   for(unsigned int i = 0; i < sizeof(programs) / sizeof(programs[0]); i++)
+   {
+      QFile file(QFINDTESTDATA(QString("../gentree/") + programs[i]));
+      if(!file.open(QIODevice::ReadOnly | QIODevice::Text))
+         continue;
+      QTextStream in(&file);
+      names << programs[i];
+      sources << in.readAll();
+   }
+   
+   for(int i = 0; i < sources.count(); i++)
+   {
+      for(int j = 0; j < sizes.count(); j++)
+      {
+         QString text = (i == 0) ? syntheticSource(sizes[j]) : resizeSource(sources[i], sizes[j]);
+         QString row = names[i] + "-" + QString::number(sizes[j]);
+         QTest::newRow(row.toLatin1().constData()) << text;
+      }
+   }
+}
@@ -0,0 +1,34 @@
+// testsources.h - Caml sources the tests and benchmarks run on
+// This file is part of LemonCaml - Copyright (C) 2012-2014 Corentin FERRY
+// 
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// 
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+// 
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TESTSOURCES_H
+#define TESTSOURCES_H
+
+#include <QString>
+#include <QList>
+
+//a synthetic Caml Light program of the given number of lines
+QString syntheticSource(int lines);
+
+//repeats (or truncates) a real program to the given number of lines
+QString resizeSource(const QString &text, int lines);
+
+/* Adds a "text" column to the current test data, and one row per size
+ * for the synthetic program and for each program of gentree/, named
+ * after the source and its number of lines. */
+void addSourceRows(const QList<int> &sizes);
+
+#endif